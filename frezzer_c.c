@@ -1,316 +1,4159 @@
 ﻿#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <time.h>
 #include <dirent.h>
 #include <sys/stat.h>
+#ifdef _WIN32
 #include <direct.h>
+#endif
+#include <pthread.h>
+#include <stdatomic.h>
+#include <errno.h>
+#include <fcntl.h>
+#ifndef _WIN32
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/file.h>
+#define _mkdir(path) mkdir((path), 0777)  // Linux下没有direct.h，换成POSIX的同名函数
+#define _rmdir(path) rmdir(path)
+#else
+#include <io.h>
+#include <sys/locking.h>
+#endif
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#endif
+
+#ifndef FREZZER_CAPACITY
+#define FREZZER_CAPACITY 100  // 冰柜容量，编译时可改，如大型冰柜 -DFREZZER_CAPACITY=1000000
+#endif
+#ifndef FREZZER_TEMP_MIN
+#define FREZZER_TEMP_MIN -20  // 允许的最低温度，编译时可改
+#endif
+#ifndef FREZZER_TEMP_MAX
+#define FREZZER_TEMP_MAX 10  // 允许的最高温度，编译时可改
+#endif
+#define FREZZER_TEMP_RANGE (FREZZER_TEMP_MAX - FREZZER_TEMP_MIN + 1)  // 温度直方图的格数
+#define FREZZER_STR2(x) #x
+#define FREZZER_STR(x) FREZZER_STR2(x)  // 把上面的常量写进提示文字
+_Static_assert(FREZZER_CAPACITY > 0 && FREZZER_CAPACITY <= 1000000000, "FREZZER_CAPACITY must be from 1 to 1e9");
+_Static_assert(FREZZER_TEMP_MIN <= FREZZER_TEMP_MAX && FREZZER_TEMP_MIN >= -32768 && FREZZER_TEMP_MAX <= 32767, "temperature limits must fit in a 16-bit record field");
 
 int warehouse_number = 0;  // 全局变量：仓库数量，用于生成新仓库的命名编号
+int freezer_binary_format = 1;  // 全局变量：冰柜是否以二进制格式保存，环境变量 FREZZER_FORMAT=text 时为0
+int delete_in_background = 1;  // 全局变量：删除仓库时先改名为墓碑再由后台线程删除，环境变量 FREZZER_DELETE=sync 时为0（当场删完）
+int worker_threads = 0;  // 全局变量：并行读取和删除用的线程数，0表示按CPU核数，由环境变量 FREZZER_THREADS 设置
+int freezer_page_size = 20;  // 全局变量：食物列表每页显示的行数，可在菜单中用 Show Top N 修改
+
+#define JOURNAL_FSYNC_NEVER 0  // 日志只交给操作系统，不主动落盘
+#define JOURNAL_FSYNC_CLOSE 1  // 离开冰柜时落盘一次（默认）
+#define JOURNAL_FSYNC_ALWAYS 2  // 每条记录都立即落盘
+int journal_fsync_policy = JOURNAL_FSYNC_CLOSE;  // 全局变量：日志的落盘策略，由环境变量 FREZZER_FSYNC=never/close/always 设置
+
+// 结构体：食物信息
+typedef struct food {
+    char food_name[100];  // 食物名称，最大长度99个字符
+    char food_type[100];  // 食物种类（如蔬菜、肉类、水果）
+    int food_volume;  // 食物体积
+    int food_temperature;  // 食物保存的温度
+}food;
+
+// 结构体：容器中实际存放的紧凑食物记录（24字节），存取时与food互相转换
+typedef struct food_record {
+    char name[16];  // 名称不超过15字节时直接存在这里（以'\0'结尾）；更长时name[0]为0xFF，第4~7字节存溢出区中的偏移，第8~11字节存长度
+    int32_t volume;  // 食物体积
+    int16_t temperature;  // 食物保存的温度
+    uint16_t type_id;  // 食物种类在种类字典中的编号
+} food_record;
+
+#define FOOD_TYPE_NONE 0xFFFF  // 无效的种类编号
+#define FOOD_TYPE_CHUNK 256  // 名称表每块的编号数
+#define FOOD_TYPE_MIN_SLOTS 64  // 散列表最初的槽数
+
+// 结构体：种类字典的散列表，种类数超过槽数一半时换一张两倍大的新表
+typedef struct food_type_table {
+    uint32_t mask;  // 槽数减1，槽数总是2的幂
+    struct food_type_table* older;  // 换下来的旧表：别的线程可能还在查，不释放（加起来不超过当前表的大小）
+    atomic_int slots[];  // 开放寻址，存 编号+1，0表示空位
+} food_type_table;
+
+// 结构体：食物种类字典，把种类字符串换成16位编号；整个进程共用一份，查找不加锁，只有新增种类时加锁
+//         散列表和名称表都随种类数增长，只有几个种类时只占几KB
+typedef struct food_type_dictionary {
+    char** chunks[FOOD_TYPE_NONE / FOOD_TYPE_CHUNK + 1];  // 编号 -> 种类名称，按块分配；块分配后不再移动，名称写入后不再改动
+    _Atomic(food_type_table*) table;  // 当前的散列表，NULL表示还没有种类
+    atomic_int count;  // 已有的种类数
+    pthread_mutex_t lock;  // 新增种类时加锁
+} food_type_dictionary;
+
+food_type_dictionary food_types = { .lock = PTHREAD_MUTEX_INITIALIZER };  // 全局变量：种类字典
+// 结构体：排序树节点，与食物槽位一一对应（树堆，按体积降序维护显示顺序）
+typedef struct order_link {
+    int left, right;  // 左右子树的槽位号，-1表示空
+    int prev, next;  // 显示顺序中的前一个/后一个槽位，-1表示没有；空槽用next串成空槽链表
+    int size;  // 子树大小，0表示这是一个空槽
+    uint32_t prio;  // 优先级，父节点总是大于子节点，用来保持树的平衡
+    uint32_t seq;  // 插入序号，体积相同时序号小的排前面
+} order_link;
+
+// 结构体：按种类、按名称两个散列索引中，每个槽位的链表指针
+typedef struct index_link {
+    int type_prev, type_next;  // 种类索引同一个桶中的前后槽位，-1表示没有（种类索引直接用种类编号分桶）
+    int name_prev, name_next;  // 名称索引同一个桶中的前后槽位，-1表示没有
+    uint32_t name_hash;  // 缓存的名称散列值，扩容重建时不用重新计算
+} index_link;
+
+// 结构体：食物容器，所有记录连续存放在一块数组中，按需扩容
+// 内存主要是两块：槽位块（items、links、index 三个数组依次放在一起）和桶块，另有长名称用的溢出区；清空冰柜时保留内存，下次加载直接复用
+typedef struct food_store {
+    char* block;  // 槽位块
+    food_record* items;  // 食物槽位数组，删除后留下的空槽会被复用
+    order_link* links;  // 与items一一对应的排序信息
+    index_link* index;  // 与items一一对应的散列索引信息
+    int* type_buckets;  // 桶块的前半部分：种类索引的桶，存链表头槽位，-1表示空桶
+    int* name_buckets;  // 桶块的后半部分：名称索引的桶
+    char* spill;  // 溢出区：超过15字节的名称存在这里
+    uint32_t spill_used;  // 溢出区已用的字节数
+    uint32_t spill_live;  // 其中仍被记录引用的字节数，其余是删改留下的，扩容前超过一半时先整理
+    uint32_t spill_capacity;  // 溢出区已分配的字节数
+    int bucket_count;  // 两个索引正在使用的桶数，总是2的幂，0表示还没建索引
+    int bucket_capacity;  // 桶块能容纳的桶数（每个索引）
+    int allocations;  // 容器创建以来向系统申请内存的次数
+    int count;  // 当前存放的食物数量
+    int used;  // 用过的槽位数（含空槽）
+    int capacity;  // 数组已分配的容量
+    int free_slot;  // 空槽链表的头，-1表示没有空槽
+    int root;  // 排序树的根，-1表示空树
+    int first;  // 显示顺序的第一个槽位，-1表示没有食物
+    uint32_t next_seq;  // 下一个插入序号
+    uint32_t rng;  // 生成优先级用的随机数状态
+} food_store;
+
+// 结构体：冰柜信息
+typedef struct frezzer {
+    food_store store;  // 冰柜中的食物
+    int frezzer_temperature;  // 冰柜的温度
+    int frezzer_available_volume;  // 冰柜的可用容积
+    int temp_histogram[FREZZER_TEMP_RANGE];  // 允许范围内各温度的食物数量（下标为温度减去最低温度），删除最冷的食物时用来找新的最低温度
+    int temp_below_range;  // 温度低于允许范围的食物数量（只会来自未校验的文件），不为0时最低温度需要重新遍历
+    int load_errors;  // 读取文本文件时读不懂的行数；不为0时不再整体重写这个冰柜，以免丢掉这些行
+} frezzer;
+
+// 结构体：冰柜的修改日志（frezzerN.journal），每次修改追加一行，读取冰柜时在基础文件之上重放
+typedef struct freezer_journal {
+    FILE* fp;  // 以追加方式打开的日志文件，NULL表示还没有修改过（第一次修改时才打开或新建）
+    int active;  // 是否记日志：为0时（打开或写入失败）离开冰柜时整体保存
+    int records;  // 日志中的记录数（含之前留下的）
+    char header[128];  // 打开时基础文件对应的日志第一行，别的进程整理、替换了基础文件后就对不上了
+    long long size;  // 本进程最后一次读写后日志的大小（没有日志为-1），别的进程追加过记录后就对不上了
+} freezer_journal;
+
+#define STATS_TIMER_LOAD 0  // 读取冰柜（基础文件 + 日志）
+#define STATS_TIMER_SAVE 1  // 保存冰柜
+#define STATS_TIMER_SORT 2  // 排序
+#define STATS_TIMER_STATUS 3  // 完整计算冰柜状态
+#define STATS_TIMER_SCAN 4  // 扫描目录（仓库列表、冰柜列表）
+#define STATS_TIMER_QUERY 5  // 查询（冰柜内按种类、所有仓库）
+#define STATS_TIMERS 6
+#define STATS_BYTES_READ 0  // 读取的字节数
+#define STATS_BYTES_WRITTEN 1  // 写出的字节数
+#define STATS_FILES_STATED 2  // stat 的次数
+#define STATS_ALLOCATIONS 3  // 食物容器向系统申请内存的次数
+#define STATS_COUNTERS 4
+#define STATS_BUCKETS 24  // 耗时直方图的格数：第k格为[2^k, 2^(k+1))微秒（第0格为2微秒以下），最后一格包含更长的
+
+// 结构体：一项被计时的操作：次数、总耗时、最长耗时和耗时直方图（多个线程同时更新，全用原子操作）
+typedef struct stats_timer {
+    atomic_llong count;
+    atomic_llong total_ns;
+    atomic_llong max_ns;
+    atomic_llong buckets[STATS_BUCKETS];
+} stats_timer;
+
+int stats_enabled = 0;  // 全局变量：是否记录性能统计，由环境变量 FREZZER_STATS=1 打开；关闭时每处只多一次判断
+stats_timer stats_timers[STATS_TIMERS];  // 全局变量：各项操作的计时
+atomic_llong stats_counters[STATS_COUNTERS];  // 全局变量：各项计数
+
+double now_ms() {  // 单调时钟的当前时间（毫秒），用于计时
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+double stats_start() {  // 开始计时，统计关闭时不读时钟
+    return stats_enabled ? now_ms() : 0;
+}
+
+void stats_stop(int timer, double start) {  // 结束计时，记入次数、总耗时、最长耗时和直方图
+    if (!stats_enabled) return;
+    long long ns = (long long)((now_ms() - start) * 1e6);
+    stats_timer* t = &stats_timers[timer];
+    atomic_fetch_add(&t->count, 1);
+    atomic_fetch_add(&t->total_ns, ns);
+    long long max = atomic_load(&t->max_ns);
+    for (; ns > max && !atomic_compare_exchange_weak(&t->max_ns, &max, ns); );
+    int k = 0;
+    for (long long us = ns / 1000; us > 1 && k < STATS_BUCKETS - 1; us >>= 1) k++;
+    atomic_fetch_add(&t->buckets[k], 1);
+}
+
+void stats_count(int counter, long long n) {  // 累加一项计数
+    if (stats_enabled) atomic_fetch_add(&stats_counters[counter], n);
+}
+
+int stat_file(const char* path, struct stat* st) {  // 带计数的 stat
+    stats_count(STATS_FILES_STATED, 1);
+    return stat(path, st);
+}
+
+long long stats_percentile_us(const stats_timer* t, long long count, double fraction) {  // 按直方图估计分位数：返回所在格的上界（微秒）
+    long long rank = (long long)(count * fraction), seen = 0;
+    for (int k = 0; k < STATS_BUCKETS; k++) {
+        seen += atomic_load(&t->buckets[k]);
+        if (seen > rank) return 2LL << k;
+    }
+    return 2LL << (STATS_BUCKETS - 1);
+}
+
+void stats_dump() {  // 输出所有计时和计数
+    const char* names[STATS_TIMERS] = {"load", "save", "sort", "status", "scan", "query"};
+    printf("\n=== Stats ===\n");
+    if (!stats_enabled) {
+        printf("Stats are off, run with FREZZER_STATS=1 to collect them.\n");
+        return;
+    }
+    printf("%-8s %10s %12s %10s %10s %10s %10s\n", "Timer", "Count", "Total(ms)", "Avg(us)", "p50(us)", "p99(us)", "Max(us)");
+    for (int i = 0; i < STATS_TIMERS; i++) {
+        const stats_timer* t = &stats_timers[i];
+        long long count = atomic_load(&t->count);
+        if (count == 0) {
+            printf("%-8s %10d\n", names[i], 0);
+            continue;
+        }
+        long long total = atomic_load(&t->total_ns);
+        printf("%-8s %10lld %12.3f %10.1f %10lld %10lld %10.1f\n", names[i], count, total / 1e6, total / 1e3 / (double)count,
+               stats_percentile_us(t, count, 0.5), stats_percentile_us(t, count, 0.99), atomic_load(&t->max_ns) / 1e3);
+        printf("         ");  // 直方图：只列出非空的格，<N 表示耗时小于N微秒
+        for (int k = 0; k < STATS_BUCKETS; k++) {
+            long long n = atomic_load(&t->buckets[k]);
+            if (n > 0) printf(" %s%lldus:%lld", k == STATS_BUCKETS - 1 ? ">=" : "<", k == STATS_BUCKETS - 1 ? 1LL << k : 2LL << k, n);
+        }
+        printf("\n");
+    }
+    printf("Bytes read: %lld, bytes written: %lld, files stat'ed: %lld, allocations: %lld\n",
+           atomic_load(&stats_counters[STATS_BYTES_READ]), atomic_load(&stats_counters[STATS_BYTES_WRITTEN]),
+           atomic_load(&stats_counters[STATS_FILES_STATED]), atomic_load(&stats_counters[STATS_ALLOCATIONS]));
+}
+
+void food_store_reset(food_store* s) {  // 清空容器但保留已申请的内存，O(1)
+    s->bucket_count = 0;  // 索引在下次插入或批量建好时重建
+    s->spill_used = 0;
+    s->spill_live = 0;
+    s->count = 0;
+    s->used = 0;
+    s->free_slot = -1;
+    s->root = -1;
+    s->first = -1;
+    s->next_seq = 0;
+}
+
+void food_store_init(food_store* s) {  // 初始化食物容器，不分配内存
+    s->block = NULL;
+    s->items = NULL;
+    s->links = NULL;
+    s->index = NULL;
+    s->type_buckets = NULL;
+    s->name_buckets = NULL;
+    s->spill = NULL;
+    s->spill_capacity = 0;
+    s->bucket_capacity = 0;
+    s->allocations = 0;
+    s->capacity = 0;
+    s->rng = 2463534242u;  // xorshift的种子不能为0
+    food_store_reset(s);
+}
+
+void food_store_free(food_store* s) {  // 释放食物容器的全部内存，并恢复为空容器
+    free(s->block);
+    free(s->type_buckets);
+    free(s->spill);
+    food_store_init(s);
+}
+
+uint32_t food_store_random(food_store* s) {  // xorshift32随机数，每个容器各用各的状态
+    uint32_t x = s->rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return s->rng = x;
+}
+
+int food_store_live(const food_store* s, int slot) {  // 判断槽位中是否存放着食物
+    return s->links[slot].size != 0;
+}
+
+uint32_t hash_string(const char* str) {  // FNV-1a 散列
+    uint32_t h = 2166136261u;
+    for (; *str; str++) h = (h ^ (unsigned char)*str) * 16777619u;
+    return h;
+}
+
+const char* food_type_name_at(int id) {  // 取已公开的编号的名称，不检查范围
+    return food_types.chunks[id / FOOD_TYPE_CHUNK][id % FOOD_TYPE_CHUNK];
+}
+
+int food_type_probe(const food_type_table* t, const char* name, uint32_t* pos) {  // 在散列表t中查找名称，找到返回编号；找不到返回-1，pos为可以放入的空位
+    if (t == NULL) return -1;
+    uint32_t i = hash_string(name) & t->mask;
+    for (;; i = (i + 1) & t->mask) {
+        int v = atomic_load_explicit(&t->slots[i], memory_order_acquire);  // 看到编号时，对应的名称一定已经写好
+        if (v == 0) break;
+        if (strcmp(food_type_name_at(v - 1), name) == 0) return v - 1;
+    }
+    *pos = i;
+    return -1;
+}
+
+uint16_t food_type_find(const char* name) {  // 查找种类的编号，字典中没有时返回FOOD_TYPE_NONE，可以多个线程同时调用
+    uint32_t pos;
+    int id = food_type_probe(atomic_load_explicit(&food_types.table, memory_order_acquire), name, &pos);
+    return id == -1 ? FOOD_TYPE_NONE : (uint16_t)id;
+}
+
+food_type_table* food_type_grow(food_type_table* old, int count) {  // 换一张两倍大的散列表，把已有的count个种类放进去再公开（须持有 food_types.lock），失败返回NULL
+    uint32_t slots = old != NULL ? (old->mask + 1) * 2 : FOOD_TYPE_MIN_SLOTS;
+    food_type_table* t = (food_type_table*)calloc(1, sizeof(food_type_table) + slots * sizeof(atomic_int));
+    if (t == NULL) return NULL;
+    t->mask = slots - 1;
+    t->older = old;
+    for (int id = 0; id < count; id++) {
+        uint32_t i = hash_string(food_type_name_at(id)) & t->mask;
+        for (; atomic_load_explicit(&t->slots[i], memory_order_relaxed) != 0; i = (i + 1) & t->mask);
+        atomic_store_explicit(&t->slots[i], id + 1, memory_order_relaxed);
+    }
+    atomic_store_explicit(&food_types.table, t, memory_order_release);
+    return t;
+}
+
+/*
+ * 函数：food_type_intern
+ * 功能：取种类的编号，字典中还没有时加进去；可以多个线程同时调用
+ * 参数：name - 种类名称
+ * 返回：种类编号，字典已满或内存不足时返回FOOD_TYPE_NONE
+ */
+uint16_t food_type_intern(const char* name) {
+    uint32_t pos;
+    int id = food_type_find(name);
+    if (id != FOOD_TYPE_NONE) return (uint16_t)id;
+
+    pthread_mutex_lock(&food_types.lock);
+    food_type_table* t = atomic_load(&food_types.table);
+    id = food_type_probe(t, name, &pos);  // 加锁后再查一次，别的线程可能刚加进去
+    int count = atomic_load(&food_types.count);
+    if (id == -1 && count < FOOD_TYPE_NONE) {
+        if (t == NULL || (uint32_t)(count + 1) * 2 > t->mask + 1) {  // 放进去后会超过一半：先换大表，再重新找空位
+            t = food_type_grow(t, count);
+            if (t != NULL) food_type_probe(t, name, &pos);
+        }
+        char*** chunk = &food_types.chunks[count / FOOD_TYPE_CHUNK];
+        if (t != NULL && *chunk == NULL) *chunk = (char**)calloc(FOOD_TYPE_CHUNK, sizeof(char*));
+        size_t len = strlen(name);
+        char* copy = t != NULL && *chunk != NULL ? (char*)malloc(len + 1) : NULL;
+        if (copy != NULL) {
+            memcpy(copy, name, len + 1);
+            (*chunk)[count % FOOD_TYPE_CHUNK] = copy;
+            atomic_store(&food_types.count, count + 1);
+            atomic_store_explicit(&t->slots[pos], count + 1, memory_order_release);  // 最后再公开编号
+            id = count;
+        }
+    }
+    pthread_mutex_unlock(&food_types.lock);
+    return id == -1 ? FOOD_TYPE_NONE : (uint16_t)id;
+}
+
+const char* food_type_name(uint16_t id) {  // 由编号取种类名称
+    return id < atomic_load(&food_types.count) ? food_type_name_at(id) : "?";
+}
+
+int food_record_spilled(const food_record* r) {  // 名称是否存在溢出区
+    return (unsigned char)r->name[0] == 0xFF;
+}
+
+void food_record_spill_ref(const food_record* r, uint32_t* offset, uint32_t* length) {  // 取长名称在溢出区中的偏移和长度
+    memcpy(offset, r->name + 4, sizeof(uint32_t));
+    memcpy(length, r->name + 8, sizeof(uint32_t));
+}
+
+void food_record_set_spill_ref(food_record* r, uint32_t offset, uint32_t length) {  // 把名称标记为存在溢出区的偏移offset处
+    memset(r->name, 0, sizeof(r->name));
+    r->name[0] = (char)0xFF;
+    memcpy(r->name + 4, &offset, sizeof(uint32_t));
+    memcpy(r->name + 8, &length, sizeof(uint32_t));
+}
+
+const char* food_record_name(const food_store* s, const food_record* r) {  // 取记录的名称
+    if (!food_record_spilled(r)) return r->name;
+    uint32_t offset, length;
+    food_record_spill_ref(r, &offset, &length);
+    return s->spill + offset;
+}
+
+void food_store_release_spill(food_store* s, int slot) {  // 槽位中的记录将被删除或覆盖：它的长名称不再算作在用
+    const food_record* r = &s->items[slot];
+    if (!food_record_spilled(r)) return;
+    uint32_t offset, length;
+    food_record_spill_ref(r, &offset, &length);
+    s->spill_live -= length + 1;
+}
+
+void food_store_compact_spill(food_store* s) {  // 把仍在用的长名称依次挪到一块新的溢出区，丢掉删改留下的空间，O(n)
+    char* spill = (char*)malloc(s->spill_capacity);
+    if (spill == NULL) return;
+    uint32_t used = 0;
+    for (int i = 0; i < s->used; i++) {
+        food_record* r = &s->items[i];
+        if (!food_store_live(s, i) || !food_record_spilled(r)) continue;
+        uint32_t offset, length;
+        food_record_spill_ref(r, &offset, &length);
+        memcpy(spill + used, s->spill + offset, length + 1);
+        food_record_set_spill_ref(r, used, length);
+        used += length + 1;
+    }
+    free(s->spill);
+    s->spill = spill;
+    s->spill_used = s->spill_live = used;
+    s->allocations++;
+    stats_count(STATS_ALLOCATIONS, 1);
+}
+
+int food_store_reserve_spill(food_store* s, size_t n) {  // 保证溢出区还能再放n个字节，成功返回1，失败返回0
+    if (s->spill_used + n <= s->spill_capacity) return 1;
+    if (s->spill_live < s->spill_used / 2) food_store_compact_spill(s);  // 一半以上是删改留下的，整理后多半不用扩容
+    if (s->spill_used + n <= s->spill_capacity) return 1;
+    if (s->spill_used + n > 0xFFFFFFFFu) return 0;
+    size_t new_capacity = s->spill_capacity ? (size_t)s->spill_capacity * 2 : 256;
+    if (new_capacity < s->spill_used + n) new_capacity = s->spill_used + n;
+    if (new_capacity > 0xFFFFFFFFu) new_capacity = 0xFFFFFFFFu;
+    char* spill = (char*)realloc(s->spill, new_capacity);
+    if (spill == NULL) return 0;
+    s->spill = spill;
+    s->spill_capacity = (uint32_t)new_capacity;
+    s->allocations++;
+    stats_count(STATS_ALLOCATIONS, 1);
+    return 1;
+}
+
+/*
+ * 函数：food_store_pack
+ * 功能：把food压成紧凑记录：短名称直接存进记录，长名称放进溢出区，种类换成字典编号，温度超出16位时截到边界
+ * 参数：s - 食物容器（提供溢出区）
+ * 参数：r - 输出的记录
+ * 参数：item - 要压缩的食物
+ * 返回：成功返回1，内存不足或种类太多返回0
+ */
+int food_store_pack(food_store* s, food_record* r, const food* item) {
+    uint16_t type_id = food_type_intern(item->food_type);
+    if (type_id == FOOD_TYPE_NONE) return 0;
+    size_t len = strlen(item->food_name);
+    if (len < sizeof(r->name) && (unsigned char)item->food_name[0] != 0xFF) {
+        memset(r->name, 0, sizeof(r->name));
+        memcpy(r->name, item->food_name, len);
+    } else {
+        if (!food_store_reserve_spill(s, len + 1)) return 0;
+        memcpy(s->spill + s->spill_used, item->food_name, len + 1);
+        food_record_set_spill_ref(r, s->spill_used, (uint32_t)len);
+        s->spill_used += (uint32_t)len + 1;
+        s->spill_live += (uint32_t)len + 1;
+    }
+    int t = item->food_temperature;
+    r->volume = item->food_volume;
+    r->temperature = (int16_t)(t < -32768 ? -32768 : t > 32767 ? 32767 : t);
+    r->type_id = type_id;
+    return 1;
+}
+
+void food_store_get(const food_store* s, int slot, food* out) {  // 把槽位中的记录还原成food
+    const food_record* r = &s->items[slot];
+    strncpy(out->food_name, food_record_name(s, r), sizeof(out->food_name) - 1);
+    out->food_name[sizeof(out->food_name) - 1] = '\0';
+    strncpy(out->food_type, food_type_name(r->type_id), sizeof(out->food_type) - 1);
+    out->food_type[sizeof(out->food_type) - 1] = '\0';
+    out->food_volume = r->volume;
+    out->food_temperature = r->temperature;
+}
+
+int order_size(const food_store* s, int t) {  // 子树大小，空树为0
+    return t == -1 ? 0 : s->links[t].size;
+}
+
+int order_less(const food_store* s, int a, int b) {  // 槽位a是否排在槽位b前面：体积大的在前，体积相同先插入的在前
+    int va = s->items[a].volume, vb = s->items[b].volume;
+    if (va != vb) return va > vb;
+    return s->links[a].seq < s->links[b].seq;
+}
+
+void order_update(food_store* s, int t) {  // 重新计算子树大小
+    s->links[t].size = 1 + order_size(s, s->links[t].left) + order_size(s, s->links[t].right);
+}
+
+void order_split(food_store* s, int t, int key, int* l, int* r) {  // 把树t拆成排在key前面的l和其余的r
+    if (t == -1) {
+        *l = *r = -1;
+        return;
+    }
+    if (order_less(s, t, key)) {
+        order_split(s, s->links[t].right, key, &s->links[t].right, r);
+        *l = t;
+    } else {
+        order_split(s, s->links[t].left, key, l, &s->links[t].left);
+        *r = t;
+    }
+    order_update(s, t);
+}
+
+int order_merge(food_store* s, int a, int b) {  // 合并两棵树，要求a中的所有节点都排在b前面
+    if (a == -1) return b;
+    if (b == -1) return a;
+    if (s->links[a].prio > s->links[b].prio) {
+        s->links[a].right = order_merge(s, s->links[a].right, b);
+        order_update(s, a);
+        return a;
+    }
+    s->links[b].left = order_merge(s, a, s->links[b].left);
+    order_update(s, b);
+    return b;
+}
+
+int order_erase(food_store* s, int t, int slot) {  // 从树t中摘下槽位slot，返回新的根
+    if (t == slot) return order_merge(s, s->links[t].left, s->links[t].right);
+    if (order_less(s, slot, t)) s->links[t].left = order_erase(s, s->links[t].left, slot);
+    else s->links[t].right = order_erase(s, s->links[t].right, slot);
+    order_update(s, t);
+    return t;
+}
+
+void order_link_in(food_store* s, int slot) {  // 把已写好数据的槽位按顺序挂进树和显示链表，O(log n)
+    order_link* x = &s->links[slot];
+    x->left = x->right = -1;
+    x->size = 1;
+    x->prio = food_store_random(s);
+    x->seq = s->next_seq++;
+
+    int l, r;
+    order_split(s, s->root, slot, &l, &r);
+    int prev = l, next = r;  // 前驱是l中最后一个，后继是r中第一个
+    if (prev != -1) for (; s->links[prev].right != -1; prev = s->links[prev].right);
+    if (next != -1) for (; s->links[next].left != -1; next = s->links[next].left);
+
+    x->prev = prev;
+    x->next = next;
+    if (prev != -1) s->links[prev].next = slot;
+    else s->first = slot;
+    if (next != -1) s->links[next].prev = slot;
+    s->root = order_merge(s, order_merge(s, l, slot), r);
+}
+
+void order_link_out(food_store* s, int slot) {  // 把槽位从树和显示链表中摘下，O(log n)
+    order_link* x = &s->links[slot];
+    s->root = order_erase(s, s->root, slot);
+    if (x->prev != -1) s->links[x->prev].next = x->next;
+    else s->first = x->next;
+    if (x->next != -1) s->links[x->next].prev = x->prev;
+}
+
+void index_link_in(food_store* s, int slot) {  // 把槽位挂到两个索引对应桶的链表头，O(1)
+    index_link* x = &s->index[slot];
+    x->name_hash = hash_string(food_record_name(s, &s->items[slot]));
+    int* type_head = &s->type_buckets[s->items[slot].type_id & (uint32_t)(s->bucket_count - 1)];
+    int* name_head = &s->name_buckets[x->name_hash & (uint32_t)(s->bucket_count - 1)];
+
+    x->type_prev = -1;
+    x->type_next = *type_head;
+    if (*type_head != -1) s->index[*type_head].type_prev = slot;
+    *type_head = slot;
+
+    x->name_prev = -1;
+    x->name_next = *name_head;
+    if (*name_head != -1) s->index[*name_head].name_prev = slot;
+    *name_head = slot;
+}
+
+void index_link_out(food_store* s, int slot) {  // 把槽位从两个索引中摘下（记录此时还没被改动），O(1)
+    index_link* x = &s->index[slot];
+    if (x->type_prev != -1) s->index[x->type_prev].type_next = x->type_next;
+    else s->type_buckets[s->items[slot].type_id & (uint32_t)(s->bucket_count - 1)] = x->type_next;
+    if (x->type_next != -1) s->index[x->type_next].type_prev = x->type_prev;
+
+    if (x->name_prev != -1) s->index[x->name_prev].name_next = x->name_next;
+    else s->name_buckets[x->name_hash & (uint32_t)(s->bucket_count - 1)] = x->name_next;
+    if (x->name_next != -1) s->index[x->name_next].name_prev = x->name_prev;
+}
+
+int food_store_build_index(food_store* s) {  // 按当前食物数量确定桶数并把所有食物挂进索引，O(n)，桶块够大时直接复用，成功返回1，内存不足返回0（旧索引保持不变）
+    int bucket_count = 16;
+    for (; bucket_count < s->count; bucket_count *= 2);  // 负载因子不超过1
+    if (bucket_count > s->bucket_capacity) {
+        int* buckets = (int*)malloc((size_t)bucket_count * 2 * sizeof(int));
+        if (buckets == NULL) return 0;
+        free(s->type_buckets);
+        s->type_buckets = buckets;
+        s->bucket_capacity = bucket_count;
+        s->allocations++;
+        stats_count(STATS_ALLOCATIONS, 1);
+    }
+    s->name_buckets = s->type_buckets + bucket_count;  // 只用桶块的前 2*bucket_count 个
+    s->bucket_count = bucket_count;
+    memset(s->type_buckets, 0xFF, (size_t)bucket_count * 2 * sizeof(int));  // 全部置为-1
+
+    for (int i = 0; i < s->used; i++) {
+        if (food_store_live(s, i)) index_link_in(s, i);
+    }
+    return 1;
+}
+
+int food_store_grow(food_store* s, int n) {  // 申请一块能放n个槽位的新槽位块，搬过去后释放旧块，成功返回1，失败返回0
+    char* block = (char*)malloc((size_t)n * (sizeof(food_record) + sizeof(order_link) + sizeof(index_link)));
+    if (block == NULL) return 0;
+    food_record* items = (food_record*)block;  // 三个数组依次排列，sizeof(food_record)和sizeof(order_link)都是4的倍数，对齐没有问题
+    order_link* links = (order_link*)(block + (size_t)n * sizeof(food_record));
+    index_link* index = (index_link*)((char*)links + (size_t)n * sizeof(order_link));
+    if (s->used > 0) {
+        memcpy(items, s->items, (size_t)s->used * sizeof(food_record));
+        memcpy(links, s->links, (size_t)s->used * sizeof(order_link));
+        memcpy(index, s->index, (size_t)s->used * sizeof(index_link));
+    }
+    free(s->block);
+    s->block = block;
+    s->items = items;
+    s->links = links;
+    s->index = index;
+    s->capacity = n;
+    s->allocations++;
+    stats_count(STATS_ALLOCATIONS, 1);
+    return 1;
+}
+
+int food_store_alloc_slot(food_store* s) {  // 取一个空槽，优先复用删除留下的，容量不足时成倍扩容，失败返回-1
+    if (s->free_slot != -1) {
+        int slot = s->free_slot;
+        s->free_slot = s->links[slot].next;
+        return slot;
+    }
+    if (s->used == s->capacity && !food_store_grow(s, s->capacity ? s->capacity * 2 : 16)) return -1;  // 首次分配16个，之后每次翻倍
+    return s->used++;
+}
+
+int food_store_reserve(food_store* s, int n) {  // 预先把容量扩到至少n个槽位（一次分配），成功返回1，失败返回0
+    return n <= s->capacity || food_store_grow(s, n);
+}
+
+int food_store_add(food_store* s, const food* item) {  // 批量追加：只占一个槽位，不参与排序也不进索引，全部追加完后必须调用sort_food_list，返回槽位号，失败返回-1
+    food_record r;
+    if (!food_store_pack(s, &r, item)) return -1;
+    int slot = food_store_alloc_slot(s);
+    if (slot == -1) return -1;
+    s->items[slot] = r;
+    s->links[slot].left = s->links[slot].right = -1;
+    s->links[slot].size = 1;  // 标记为有食物
+    s->count++;
+    return slot;
+}
+
+int food_store_insert(food_store* s, const food* item) {  // 按体积降序插入一个食物并加入索引，返回槽位号，失败返回-1
+    if (s->count + 1 > s->bucket_count && !food_store_build_index(s) && s->bucket_count == 0) return -1;  // 食物比桶多时先扩容索引
+    food_record r;
+    if (!food_store_pack(s, &r, item)) return -1;
+    int slot = food_store_alloc_slot(s);
+    if (slot == -1) return -1;
+    s->items[slot] = r;
+    order_link_in(s, slot);
+    index_link_in(s, slot);
+    s->count++;
+    return slot;
+}
+
+int food_store_slot_at(const food_store* s, int index) {  // 按显示下标（从0开始）找槽位，越界返回-1，O(log n)
+    if (index < 0 || index >= s->count) return -1;
+    for (int t = s->root; t != -1; ) {
+        int left_size = order_size(s, s->links[t].left);
+        if (index < left_size) {
+            t = s->links[t].left;
+        } else if (index == left_size) {
+            return t;
+        } else {
+            index -= left_size + 1;
+            t = s->links[t].right;
+        }
+    }
+    return -1;
+}
+
+food_record* food_store_at(food_store* s, int index) {  // 按显示下标取记录，越界返回NULL
+    int slot = food_store_slot_at(s, index);
+    return slot == -1 ? NULL : &s->items[slot];
+}
+
+void food_store_remove_slot(food_store* s, int slot) {  // 删除指定槽位的食物，槽位放回空槽链表
+    order_link_out(s, slot);
+    index_link_out(s, slot);
+    food_store_release_spill(s, slot);
+    s->links[slot].size = 0;  // 标记为空槽
+    s->links[slot].next = s->free_slot;
+    s->free_slot = slot;
+    s->count--;
+}
+
+int food_store_update_slot(food_store* s, int slot, const food* item) {  // 修改指定槽位的食物，重新放到正确的位置并更新索引，成功返回1，内存不足返回0（食物不变）
+    food_record r;
+    if (!food_store_pack(s, &r, item)) return 0;
+    order_link_out(s, slot);
+    index_link_out(s, slot);
+    food_store_release_spill(s, slot);
+    s->items[slot] = r;
+    order_link_in(s, slot);
+    index_link_in(s, slot);
+    return 1;
+}
+
+void food_store_remove(food_store* s, int index) {  // 删除指定显示下标的食物
+    int slot = food_store_slot_at(s, index);
+    if (slot != -1) food_store_remove_slot(s, slot);
+}
+
+int food_store_update(food_store* s, int index, const food* item) {  // 修改指定显示下标的食物，成功返回1
+    int slot = food_store_slot_at(s, index);
+    return slot != -1 && food_store_update_slot(s, slot, item);
+}
+
+int food_store_find(const food_store* s, int after, uint16_t type_id) {  // 沿种类索引查找槽位after之后的下一个指定种类（字典编号）的食物（after为-1时从头找），返回槽位号，找不到返回-1，总共O(匹配数)
+    if (s->bucket_count == 0 || type_id == FOOD_TYPE_NONE) return -1;
+    int i = after == -1 ? s->type_buckets[type_id & (uint32_t)(s->bucket_count - 1)] : s->index[after].type_next;
+    for (; i != -1; i = s->index[i].type_next) {
+        if (s->items[i].type_id == type_id) return i;  // 种类多于桶数时同一个桶里会有其他种类
+    }
+    return -1;
+}
+
+int food_store_find_name(const food_store* s, int after, const char* name) {  // 沿名称索引查找槽位after之后的下一个同名食物，用法同food_store_find
+    if (s->bucket_count == 0) return -1;
+    int i = after == -1 ? s->name_buckets[hash_string(name) & (uint32_t)(s->bucket_count - 1)] : s->index[after].name_next;
+    for (; i != -1; i = s->index[i].name_next) {
+        if (strcmp(food_record_name(s, &s->items[i]), name) == 0) return i;
+    }
+    return -1;
+}
+
+int food_store_lookup(const food_store* s, const char* key) {  // 按用户输入找食物：纯数字当作显示序号（从1开始），否则当作名称，返回槽位号，找不到返回-1
+    char* end;
+    long idx = strtol(key, &end, 10);
+    if (*key != '\0' && *end == '\0') return idx >= 1 && idx <= s->count ? food_store_slot_at(s, (int)idx - 1) : -1;
+    return food_store_find_name(s, -1, key);
+}
+
+void food_store_compact(food_store* s) {  // 把有食物的槽位按原顺序挪到数组前部，去掉空槽；之后必须重建顺序
+    int j = 0;
+    for (int i = 0; i < s->used; i++) {
+        if (!food_store_live(s, i)) continue;
+        if (i != j) s->items[j] = s->items[i];
+        s->links[j].size = 1;
+        j++;
+    }
+    s->used = j;
+    s->free_slot = -1;
+}
+
+int order_build(food_store* s, int lo, int hi, int depth) {  // 用已按顺序排好的槽位[lo,hi)建一棵平衡树，优先级的高5位按深度递减以满足堆性质
+    if (lo >= hi) return -1;
+    int mid = lo + (hi - lo) / 2;
+    order_link* x = &s->links[mid];
+    x->prio = ((uint32_t)(31 - depth) << 27) | (food_store_random(s) >> 5);
+    x->left = order_build(s, lo, mid, depth + 1);
+    x->right = order_build(s, mid + 1, hi, depth + 1);
+    x->size = hi - lo;
+    return mid;
+}
+
+void food_store_build_order(food_store* s) {  // 槽位0..count-1已按显示顺序存放且没有空槽时，一次性建好排序树、显示链表和索引，O(n)
+    for (int i = 0; i < s->count; i++) {
+        s->links[i].prev = i - 1;
+        s->links[i].next = i + 1 < s->count ? i + 1 : -1;
+        s->links[i].seq = (uint32_t)i;
+    }
+    s->first = s->count ? 0 : -1;
+    s->next_seq = (uint32_t)s->count;
+    s->root = order_build(s, 0, s->count, 0);
+    food_store_build_index(s);  // 槽位已重新排列，索引整体重建
+}
+
+void frezzer_reset(frezzer* f) {  // 清空冰柜（保留容器已申请的内存，供下次加载复用）
+    food_store_reset(&f->store);
+    f->frezzer_temperature = FREZZER_TEMP_MAX;  // 空冰柜的温度为最高允许温度
+    f->frezzer_available_volume = FREZZER_CAPACITY;  // 可用容积最大值为冰柜容量
+    memset(f->temp_histogram, 0, sizeof(f->temp_histogram));
+    f->temp_below_range = 0;
+    f->load_errors = 0;
+}
+
+void frezzer_init(frezzer* f) {  // 初始化冰柜结构体
+    food_store_init(&f->store);  // 初始化为空容器
+    frezzer_reset(f);
+}
+
+void frezzer_free(frezzer* f) {  // 释放冰柜占用的内存，之后冰柜为空，可以继续使用
+    food_store_free(&f->store);
+    frezzer_reset(f);
+}
+
+void calculate_freezer_status(frezzer* f) {  // 完整遍历冰柜，从头计算剩余容积、温度和温度直方图 传入指向冰柜的指针 无返 平时由增量更新维护，这里只用于校验
+    double start = stats_start();
+    int used_volume = 0;  // 记录已使用的容积
+    int min_temp = FREZZER_TEMP_MAX;  // 记录最低温度，初值为最高允许温度
+    memset(f->temp_histogram, 0, sizeof(f->temp_histogram));
+    f->temp_below_range = 0;
+
+    for (int i = 0; i < f->store.used; i++) { // 按槽位顺序遍历冰柜，跳过空槽
+        if (!food_store_live(&f->store, i)) continue;
+        const food_record* temp = &f->store.items[i];
+        used_volume += temp->volume; // 累加体积
+        if (temp->temperature < min_temp) {  // 求最小温度
+            min_temp = temp->temperature;
+        }
+        if (temp->temperature < FREZZER_TEMP_MIN) f->temp_below_range++;  // 记入温度直方图
+        else if (temp->temperature <= FREZZER_TEMP_MAX) f->temp_histogram[temp->temperature - FREZZER_TEMP_MIN]++;
+    }
+
+    f->frezzer_available_volume = FREZZER_CAPACITY - used_volume;  // 更新冰柜体积
+    f->frezzer_temperature=min_temp;// 更新冰柜温度
+    stats_stop(STATS_TIMER_STATUS, start);
+}
+
+/*
+ * 函数：frezzer_account
+ * 功能：放入或取出一个食物时，增量更新冰柜的剩余容积和温度，O(1)
+ * 参数：f - 指向冰柜结构体的指针
+ * 参数：volume - 放入或取出的食物的体积
+ * 参数：t - 放入或取出的食物的温度
+ * 参数：sign - 放入为1，取出为-1
+ * 返回：取出的是低于允许范围的最冷食物、最低温度只能重新遍历时返回1，否则返回0
+ */
+int frezzer_account(frezzer* f, int volume, int t, int sign) {
+    f->frezzer_available_volume -= sign * volume;
+
+    if (t > FREZZER_TEMP_MAX) return 0;  // 高于最高允许温度的食物不影响最低温度
+    if (t < FREZZER_TEMP_MIN) {  // 超出直方图范围（只会来自未校验的文件）
+        f->temp_below_range += sign;
+        if (sign > 0 && t < f->frezzer_temperature) f->frezzer_temperature = t;
+        return sign < 0 && t == f->frezzer_temperature;
+    }
+
+    f->temp_histogram[t - FREZZER_TEMP_MIN] += sign;
+    if (sign > 0) {
+        if (t < f->frezzer_temperature) f->frezzer_temperature = t;
+    } else if (t == f->frezzer_temperature && f->temp_histogram[t - FREZZER_TEMP_MIN] == 0) {
+        // 取出的是最后一个最冷的食物：沿直方图往上找下一个有食物的温度，最多 FREZZER_TEMP_RANGE 格
+        int next = t;
+        for (; next < FREZZER_TEMP_MAX && f->temp_histogram[next - FREZZER_TEMP_MIN] == 0; next++);
+        f->frezzer_temperature = next;
+    }
+    return 0;
+}
+
+#ifdef FREZZER_DEBUG
+void verify_freezer_status(frezzer* f) {  // 调试模式：每次修改后完整重算一遍，与增量结果对比
+    int volume = f->frezzer_available_volume, temperature = f->frezzer_temperature;
+    calculate_freezer_status(f);
+    if (volume != f->frezzer_available_volume || temperature != f->frezzer_temperature) {
+        printf("[debug] Status mismatch: incremental %d / %d C, recomputed %d / %d C\n",
+               volume, temperature, f->frezzer_available_volume, f->frezzer_temperature);
+    }
+}
+#else
+#define verify_freezer_status(f) ((void)0)
+#endif
+
+int frezzer_add_food(frezzer* f, const food* item) {  // 按顺序放入一个食物并更新冰柜状态，成功返回1，内存不足返回0
+    if (food_store_insert(&f->store, item) == -1) return 0;
+    frezzer_account(f, item->food_volume, item->food_temperature, 1);
+    verify_freezer_status(f);
+    return 1;
+}
+
+void frezzer_remove_food(frezzer* f, int slot) {  // 取出指定槽位的食物并更新冰柜状态
+    food_record old = f->store.items[slot];  // 先从容器中删掉，再更新状态，需要重新遍历时看到的就是删除后的冰柜
+    food_store_remove_slot(&f->store, slot);
+    if (frezzer_account(f, old.volume, old.temperature, -1)) calculate_freezer_status(f);
+    verify_freezer_status(f);
+}
+
+int frezzer_update_food(frezzer* f, int slot, const food* item) {  // 修改指定槽位的食物，重新排好位置并更新冰柜状态，成功返回1，内存不足返回0
+    food_record old = f->store.items[slot];
+    if (!food_store_update_slot(&f->store, slot, item)) return 0;
+    int rescan = frezzer_account(f, old.volume, old.temperature, -1);
+    frezzer_account(f, item->food_volume, item->food_temperature, 1);
+    if (rescan) calculate_freezer_status(f);
+    verify_freezer_status(f);
+    return 1;
+}
+
+int cmp(const void *a, const void *b) {  // qsort排序食物数组用的排序函数
+    const food *food_a = a, *food_b = b;
+    return food_b->food_volume - food_a->food_volume; // 降序排序
+}
+
+int record_cmp(const void *a, const void *b) {  // qsort排序紧凑记录用的排序函数，体积降序
+    const food_record *record_a = a, *record_b = b;
+    return (record_b->volume > record_a->volume) - (record_b->volume < record_a->volume);
+}
+
+/*
+ * 函数：make_sort_key
+ * 功能：把（体积，下标）压成一个64位键，键升序即体积降序、同体积按原下标升序
+ * 参数：volume - 食物体积
+ * 参数：index - 食物在容器中的原下标
+ */
+uint64_t make_sort_key(int volume, int index) {
+    uint32_t v = ~((uint32_t)volume ^ 0x80000000u);  // 翻转符号位得到保序的无符号数，再取反变为降序
+    return ((uint64_t)v << 32) | (uint32_t)index;
+}
+
+/*
+ * 函数：radix_sort_keys
+ * 功能：对64位键做LSD基数排序（稳定，每次8位），所有字节都相同的轮次直接跳过
+ * 参数：keys - 待排序的键，结果也写回这里
+ * 参数：buffer - 与keys等长的临时数组
+ * 参数：n - 键的个数
+ */
+void radix_sort_keys(uint64_t* keys, uint64_t* buffer, int n) {
+    uint64_t *src = keys, *dst = buffer;  // 两个数组轮流作为输入和输出
+    for (int shift = 0; shift < 64; shift += 8) {
+        size_t count[257] = {0};  // 每个字节值出现的次数，之后转为起始位置
+        for (int i = 0; i < n; i++) count[((src[i] >> shift) & 0xFF) + 1]++;
+        if (count[((src[0] >> shift) & 0xFF) + 1] == (size_t)n) continue;  // 这一字节全部相同，不用分配
+
+        for (int b = 0; b < 256; b++) count[b + 1] += count[b];
+        for (int i = 0; i < n; i++) dst[count[(src[i] >> shift) & 0xFF]++] = src[i];
+
+        uint64_t* temp = src;  // 交换输入输出
+        src = dst;
+        dst = temp;
+    }
+    if (src != keys) memcpy(keys, src, (size_t)n * sizeof(uint64_t));  // 保证结果留在keys中
+}
+
+void sort_food_list(frezzer* f) {  //对冰柜中的食物按照体积进行 降序排序，并重建显示顺序 传入指向冰柜变量的指针 批量加载后调用一次
+    double start = stats_start();
+    food_store* s = &f->store;
+    food_store_compact(s);  // 去掉空槽，槽位0..count-1都有食物
+    int n = s->count;
+
+    if (n >= 2) {
+        // 1. 只排序（体积，下标）键，不搬动整条食物记录
+        uint64_t* keys = (uint64_t*)malloc((size_t)n * 2 * sizeof(uint64_t));
+        if (keys == NULL) {  // 内存不足时退回到直接排序记录
+            qsort(s->items, n, sizeof(food_record), record_cmp);
+        } else {
+            for (int i = 0; i < n; i++) keys[i] = make_sort_key(s->items[i].volume, i);
+            radix_sort_keys(keys, keys + n, n);
+
+            // 2. 按排好的顺序原地置换记录：沿每个置换环走一遍，每条记录只移动一次
+            uint32_t* from = (uint32_t*)(keys + n);  // 复用后半段：from[k] 表示位置k应放原来的哪一条
+            for (int i = 0; i < n; i++) from[i] = (uint32_t)keys[i];
+            for (int i = 0; i < n; i++) {
+                if (from[i] == (uint32_t)i) continue;  // 已就位
+                food_record temp = s->items[i];
+                int j = i;
+                for (int src = (int)from[j]; src != i; src = (int)from[j]) {
+                    s->items[j] = s->items[src];
+                    from[j] = (uint32_t)j;  // 标记为已就位
+                    j = src;
+                }
+                s->items[j] = temp;
+                from[j] = (uint32_t)j;
+            }
+            free(keys);
+        }
+    }
+
+    // 3. 槽位顺序即显示顺序，一次建好排序树
+    food_store_build_order(s);
+    stats_stop(STATS_TIMER_SORT, start);
+}
+
+int save_freezer_to_text(const char* filepath, frezzer* f) {  // 将冰柜中的内容写成文本文件（每行一个食物），传入：文件路径 指向冰柜结构体的指针 先写临时文件再改名，成功返回1，失败返回0
+    char temp_path[610];
+    sprintf(temp_path, "%s.tmp", filepath);
+    FILE* fp = fopen(temp_path, "w");  // 以写模式打开文件
+    if (fp == NULL) {  // 若找不到，则报错并返回
+        printf("Error: Cannot save file %s\n", filepath);
+        return 0;
+    }
+
+    for (int i = f->store.first; i != -1; i = f->store.links[i].next) {  // 按显示顺序写入文件，文件中的顺序为：名字 类型 体积 温度\n
+        const food_record* temp = &f->store.items[i];
+        fprintf(fp, "%s %s %d %d\n", 
+            food_record_name(&f->store, temp), 
+            food_type_name(temp->type_id), 
+            temp->volume, 
+            temp->temperature);
+    }
+    stats_count(STATS_BYTES_WRITTEN, ftell(fp));
+    if (fclose(fp) != 0) {  // 关闭文件
+        remove(temp_path);
+        printf("Error: Cannot save file %s\n", filepath);
+        return 0;
+    }
+#ifdef _WIN32
+    remove(filepath);  // Windows下rename不能覆盖已存在的文件
+#endif
+    if (rename(temp_path, filepath) != 0) {
+        remove(temp_path);
+        printf("Error: Cannot save file %s\n", filepath);
+        return 0;
+    }
+    return 1;
+}
+
+int parse_int_field(const char* p, const char* end, int* out) {  // 解析[p,end)中的十进制整数（可带正负号），必须占满整个字段且不超出int范围，成功返回1
+    int negative = p < end && *p == '-';
+    if (p < end && (*p == '-' || *p == '+')) p++;
+    if (p == end) return 0;
+    long long v = 0;
+    for (; p < end; p++) {
+        if (*p < '0' || *p > '9') return 0;
+        v = v * 10 + (*p - '0');
+        if (v > 2147483648LL) return 0;  // 提前停止，避免超长的数字溢出
+    }
+    if (negative) v = -v;
+    if (v > 2147483647LL) return 0;
+    *out = (int)v;
+    return 1;
+}
+
+/*
+ * 函数：parse_text_row
+ * 功能：解析文本冰柜文件的一行（名称 种类 体积 温度），检查后批量追加到冰柜并累计状态
+ *       温度超出本次编译的范围时照样读入（与二进制文件一致，可能是按别的范围编译的程序写的），只返回2让调用者报告
+ * 参数：f - 指向冰柜结构体的指针
+ * 参数：p - 行的开头
+ * 参数：end - 行的结尾（不含换行）
+ * 参数：error - 出错时输出错误说明
+ * 返回：追加成功返回1，温度超出范围但已追加返回2，空行返回0，出错返回-1
+ */
+int parse_text_row(frezzer* f, const char* p, const char* end, const char** error) {
+    const char* field[4];
+    size_t len[4];
+    int n = 0;
+    for (;;) {  // 按空白切分字段，最多4个
+        for (; p < end && (*p == ' ' || *p == '\t' || *p == '\r'); p++);
+        if (p == end) break;
+        if (n == 4) { *error = "too many fields"; return -1; }
+        field[n] = p;
+        for (; p < end && *p != ' ' && *p != '\t' && *p != '\r'; p++);
+        len[n] = (size_t)(p - field[n]);
+        n++;
+    }
+    if (n == 0) return 0;
+
+    food item;
+    if (n != 4) { *error = "expected: name type volume temperature"; return -1; }
+    if (len[0] >= sizeof(item.food_name) || len[1] >= sizeof(item.food_type)) { *error = "name or type longer than 99 characters"; return -1; }
+    if (!parse_int_field(field[2], field[2] + len[2], &item.food_volume) || item.food_volume < 0) { *error = "invalid volume"; return -1; }
+    if (!parse_int_field(field[3], field[3] + len[3], &item.food_temperature)) { *error = "invalid temperature"; return -1; }
+    memcpy(item.food_name, field[0], len[0]);
+    item.food_name[len[0]] = '\0';
+    memcpy(item.food_type, field[1], len[1]);
+    item.food_type[len[1]] = '\0';
+
+    if (food_store_add(&f->store, &item) == -1) { *error = "out of memory"; return -1; }  // 批量追加，全部读完后统一排序一次
+    frezzer_account(f, item.food_volume, item.food_temperature, 1);  // 边读边累计冰柜状态
+    return item.food_temperature < FREZZER_TEMP_MIN || item.food_temperature > FREZZER_TEMP_MAX ? 2 : 1;
+}
+
+_Thread_local int load_quiet;  // 全局变量：本线程读取冰柜时不直接打印警告（每个线程一份，后台读取线程设为1）
+_Thread_local char load_notes[2048];  // 全局变量：不打印时攒下的警告（每个线程一份），放不下的部分丢掉
+_Thread_local size_t load_notes_used;  // 全局变量：load_notes 已用的字节数
+
+void load_warning(const char* format, ...) {  // 读取冰柜时的警告：平时直接打印，后台线程里追加到 load_notes，由主线程显示仓库时打印
+    va_list args;
+    va_start(args, format);
+    if (!load_quiet) {
+        vprintf(format, args);
+    } else if (load_notes_used < sizeof(load_notes) - 1) {
+        size_t room = sizeof(load_notes) - load_notes_used;
+        int n = vsnprintf(load_notes + load_notes_used, room, format, args);
+        if (n > 0) load_notes_used += (size_t)n < room ? (size_t)n : room - 1;
+    }
+    va_end(args);
+}
+
+/*
+ * 函数：load_freezer_from_text
+ * 功能：分块读取文本格式的冰柜文件：每次读入一整块，逐行解析并检查（字段个数、数字、字段长度），读不懂的行跳过、报告并计入 load_errors，读完后统一排序一次
+ *       容量和温度范围只报告、不丢行，与读取二进制文件一致；容量在全部读完后才检查，结果与行的先后顺序无关
+ * 参数：filepath - 文件路径
+ * 参数：f - 指向已初始化的冰柜结构体的指针
+ */
+void load_freezer_from_text(const char* filepath, frezzer* f) {
+    frezzer_reset(f); // 先清空冰柜，之前申请的内存留着复用
+    FILE* fp = fopen(filepath, "rb"); // 以二进制模式读，换行自己处理
+    if (fp == NULL) {
+        // 如果文件不存在，则报错并返回
+        load_warning("Error: Cannot find file %s\n", filepath);
+        return;
+    }
+    struct stat st;  // 按文件大小预估行数（每行至少约24字节），一次申请够，避免反复扩容
+    if (fstat(fileno(fp), &st) == 0) food_store_reserve(&f->store, (int)(st.st_size / 24) + 1);
+
+    char buffer[65536];  // 读缓冲区，放不下一整行的行直接算作错误
+    size_t have = 0;  // 缓冲区中还没解析的字节数（上一块末尾不完整的行）
+    int line = 0, bad = 0, outside = 0, skipping = 0;  // outside：温度超出范围的行数；skipping：正在丢弃一个超长行的剩余部分
+    for (;;) {
+        size_t got = fread(buffer + have, 1, sizeof(buffer) - have, fp);
+        stats_count(STATS_BYTES_READ, (long long)got);
+        char *p = buffer, *end = buffer + have + got;
+        for (;;) {
+            char* newline = (char*)memchr(p, '\n', (size_t)(end - p));
+            if (newline == NULL && (got > 0 || p == end)) break;  // 不完整的行留到下一块；文件结束时最后一行可以没有换行
+            char* row_end = newline ? newline : end;
+            line++;
+            const char* error = NULL;
+            int result = skipping ? 0 : parse_text_row(f, p, row_end, &error);
+            skipping = 0;
+            if (result == 2) outside++;
+            if (result == -1 && ++bad <= 5) {  // 只逐行报告前5个
+                load_warning("Warning: %s line %d: %s, row skipped\n", filepath, line, error);
+            }
+            p = newline ? newline + 1 : end;
+        }
+        if (got == 0) break;
+        have = (size_t)(end - p);
+        if (have == sizeof(buffer)) {  // 一行比缓冲区还长：报告一次，丢弃到下一个换行为止
+            if (!skipping && ++bad <= 5) load_warning("Warning: %s line %d: line too long, row skipped\n", filepath, line + 1);
+            skipping = 1;
+            have = 0;
+        } else {
+            memmove(buffer, p, have);
+        }
+    }
+    if (bad > 5) load_warning("Warning: %s: %d more bad row(s) skipped\n", filepath, bad - 5);
+    if (bad > 0) load_warning("Warning: %s will not be rewritten until the skipped row(s) are fixed\n", filepath);
+    f->load_errors = bad;
+    if (outside > 0) {
+        load_warning("Warning: %s has %d food(s) outside %d..%d C, kept as they are\n", filepath, outside, FREZZER_TEMP_MIN, FREZZER_TEMP_MAX);
+    }
+    if (f->frezzer_available_volume < 0) {
+        load_warning("Warning: %s holds %d more than the capacity of %d, no food can be added\n", filepath, -f->frezzer_available_volume, FREZZER_CAPACITY);
+    }
+    fclose(fp); // 关闭文件
+
+    sort_food_list(f);  // 读取完成后统一排序一次
+}
+
+// 结构体：二进制冰柜文件的文件头（本机字节序）
+// 版本2的文件：文件头 | count条按显示顺序排好的food_record | 种类表 | 溢出区；版本1的文件头没有最后三项，后面紧跟count条food记录
+typedef struct freezer_file_header {
+    char magic[4];  // 固定为 "FRZB"
+    uint32_t version;  // 格式版本，目前写出的是3，版本1、2仍可读取
+    uint32_t record_size;  // 每条记录的字节数，版本1等于sizeof(food)，版本2等于sizeof(food_record)
+    uint32_t count;  // 食物数量
+    int32_t available_volume;  // 预先算好的可用容积
+    int32_t temperature;  // 预先算好的最低温度
+    int32_t temp_below_range;  // 与冰柜结构体中的同名字段一致
+    int32_t temp_histogram[31];  // 温度直方图，格数固定；编译时的温度范围不是31格时不使用，读取时重新计算
+    uint32_t type_count;  // 种类表中的种类数，记录中的种类编号是种类表中的下标
+    uint32_t type_bytes;  // 种类表的字节数，各种类名称依次存放，每个以'\0'结尾
+    uint32_t spill_bytes;  // 溢出区的字节数，记录中长名称的偏移相对于溢出区开头
+    int32_t capacity;  // 写文件时的冰柜容量（版本3起；更早的版本按100）
+    int32_t temp_min;  // 写文件时的最低允许温度（版本3起；更早的版本按-20）
+    int32_t temp_max;  // 写文件时的最高允许温度（版本3起；更早的版本按10）
+} freezer_file_header;
+
+#define FREEZER_HEADER_V1_SIZE offsetof(freezer_file_header, type_count)  // 版本1文件头的字节数
+#define FREEZER_HEADER_V2_SIZE offsetof(freezer_file_header, capacity)  // 版本2文件头的字节数
+
+void freezer_binary_path(const char* text_path, char* out) {  // 由 xxx.txt 得到同名的二进制文件路径 xxx.frz
+    strcpy(out, text_path);
+    char* dot = strrchr(out, '.');
+    if (dot && strcmp(dot, ".txt") == 0) strcpy(dot, ".frz");
+    else strcat(out, ".frz");
+}
+
+long long stat_mtime_ns(const struct stat* st) {  // 取文件修改时间，能取到纳秒时尽量取纳秒
+#if defined(__linux__)
+    return (long long)st->st_mtim.tv_sec * 1000000000LL + st->st_mtim.tv_nsec;
+#else
+    return (long long)st->st_mtime * 1000000000LL;
+#endif
+}
+
+/*
+ * 函数：freezer_uses_binary
+ * 功能：判断某个冰柜应该从哪个文件读取：二进制文件存在且比文本文件新时用二进制
+ *       按纳秒比较修改时间；时间相同（文件系统只精确到秒时，同一秒内改过文本）时用文本，手工修改不会被忽略
+ * 参数：text_path - 冰柜的文本文件路径（xxx.txt）
+ * 参数：binary_path - 输出对应的二进制文件路径
+ * 返回：用二进制文件返回1，用文本文件返回0
+ */
+int freezer_uses_binary(const char* text_path, char* binary_path) {
+    freezer_binary_path(text_path, binary_path);
+    struct stat binary_stat, text_stat;
+    if (stat_file(binary_path, &binary_stat) != 0) return 0;
+    if (stat_file(text_path, &text_stat) != 0) return 1;
+    return stat_mtime_ns(&binary_stat) > stat_mtime_ns(&text_stat);  // 文本文件更新（例如手工编辑过）或同时写成时重新导入文本
+}
+
+size_t freezer_header_size(const freezer_file_header* h) {  // 这个版本的文件头的字节数
+    return h->version == 1 ? FREEZER_HEADER_V1_SIZE : h->version == 2 ? FREEZER_HEADER_V2_SIZE : sizeof(freezer_file_header);
+}
+
+int freezer_header_valid(const freezer_file_header* h, size_t file_size) {  // 检查文件头与文件长度是否匹配，h须由 freezer_read_header 读出
+    if (memcmp(h->magic, "FRZB", 4) != 0 || h->count > 0x7FFFFFFFu) return 0;
+    if (h->version == 1) {
+        return h->record_size == sizeof(food) && file_size == FREEZER_HEADER_V1_SIZE + (size_t)h->count * sizeof(food);
+    }
+    return (h->version == 2 || h->version == 3) && h->record_size == sizeof(food_record)
+        && file_size == freezer_header_size(h) + (size_t)h->count * sizeof(food_record) + h->type_bytes + h->spill_bytes;
+}
+
+int freezer_header_policy_matches(const freezer_file_header* h) {  // 文件是不是按当前编译的容量和温度范围写的，是时文件头中预先算好的可用容积和温度可以直接用
+    return h->capacity == FREZZER_CAPACITY && h->temp_min == FREZZER_TEMP_MIN && h->temp_max == FREZZER_TEMP_MAX;
+}
+
+int freezer_read_header(freezer_file_header* h, const void* data, size_t size) {  // 从文件开头的size个字节中取出文件头，不够一个版本1文件头时返回0
+    memset(h, 0, sizeof(*h));
+    memcpy(h, data, size < sizeof(*h) ? size : sizeof(*h));
+    if (size < FREEZER_HEADER_V1_SIZE) return 0;
+    size_t header_size = freezer_header_size(h);
+    if (header_size < sizeof(*h)) {  // 旧版本的文件头较短：后面读进来的是记录，清零，并补上当时固定的容量和温度范围
+        memset((char*)h + header_size, 0, sizeof(*h) - header_size);
+        h->capacity = 100;
+        h->temp_min = -20;
+        h->temp_max = 10;
+    }
+    return 1;
+}
+
+void load_freezer_header(frezzer* f, const freezer_file_header* h) {  // 直接使用文件头中预先算好的冰柜状态；文件按别的容量或温度范围写成时重新计算
+    if (!freezer_header_policy_matches(h) || FREZZER_TEMP_RANGE != 31) {
+        calculate_freezer_status(f);
+        return;
+    }
+    f->frezzer_available_volume = h->available_volume;
+    f->frezzer_temperature = h->temperature;
+    f->temp_below_range = h->temp_below_range;
+    memcpy(f->temp_histogram, h->temp_histogram, sizeof(f->temp_histogram));
+}
+
+void adopt_loaded_records(food_store* s, int n) {  // 槽位0..n-1已按显示顺序写好记录：标记为有食物并建好顺序
+    for (int i = 0; i < n; i++) s->links[i].size = 1;
+    s->count = s->used = n;
+    food_store_build_order(s);
+}
+
+/*
+ * 函数：load_freezer_records
+ * 功能：把版本2文件中的记录、种类表和溢出区整块复制进容器，只把种类编号换成本进程字典中的编号，并检查长名称没有越界
+ * 参数：s - 食物容器（已清空）
+ * 参数：h - 已校验过的文件头
+ * 参数：data - 文件头之后的内容
+ * 返回：成功返回1，文件损坏或内存不足返回0
+ */
+int load_freezer_records(food_store* s, const freezer_file_header* h, const char* data) {
+    int n = (int)h->count;
+    const char* types = data + (size_t)n * sizeof(food_record);
+    const char* types_end = types + h->type_bytes;
+    const char* spill = types_end;
+
+    uint16_t* remap = (uint16_t*)malloc(((size_t)h->type_count + 1) * sizeof(uint16_t));  // 文件中的种类编号 -> 字典中的编号
+    int ok = remap != NULL && food_store_reserve(s, n) && food_store_reserve_spill(s, h->spill_bytes);
+    for (uint32_t t = 0; ok && t < h->type_count; t++) {
+        const char* end = (const char*)memchr(types, '\0', (size_t)(types_end - types));
+        ok = end != NULL && (remap[t] = food_type_intern(types)) != FOOD_TYPE_NONE;
+        types = end + 1;
+    }
+    if (ok && n > 0) {  // 空冰柜时 s->items 可能还是NULL
+        memcpy(s->items, data, (size_t)n * sizeof(food_record));
+        if (h->spill_bytes > 0) memcpy(s->spill, spill, h->spill_bytes);
+        s->spill_used = s->spill_live = h->spill_bytes;
+    }
+    for (int i = 0; ok && i < n; i++) {
+        food_record* r = &s->items[i];
+        ok = r->type_id < h->type_count;
+        if (ok) r->type_id = remap[r->type_id];
+        if (ok && food_record_spilled(r)) {
+            uint32_t offset, length;
+            food_record_spill_ref(r, &offset, &length);
+            ok = offset < h->spill_bytes && length < h->spill_bytes - offset && s->spill[offset + length] == '\0';
+        } else {
+            r->name[sizeof(r->name) - 1] = '\0';  // 防止损坏的文件让字符串越界
+        }
+    }
+    free(remap);
+    return ok;
+}
+
+/*
+ * 函数：load_freezer_image
+ * 功能：从内存中的整个二进制文件读取冰柜：记录已按显示顺序排好，状态已存在文件头里，不用逐行解析和排序；版本1的文件逐条压缩成紧凑记录
+ * 参数：f - 指向已清空的冰柜结构体的指针
+ * 参数：data - 文件内容
+ * 参数：size - 文件字节数
+ * 返回：成功返回1，文件损坏或内存不足返回0
+ */
+int load_freezer_image(frezzer* f, const char* data, size_t size) {
+    freezer_file_header h;
+    if (!freezer_read_header(&h, data, size) || !freezer_header_valid(&h, size)) return 0;
+    food_store* s = &f->store;
+    int n = (int)h.count;
+    if (h.version == 1) {
+        if (!food_store_reserve(s, n)) return 0;
+        for (int i = 0; i < n; i++) {
+            food item;
+            memcpy(&item, data + FREEZER_HEADER_V1_SIZE + (size_t)i * sizeof(food), sizeof(food));
+            item.food_name[99] = '\0';  // 防止损坏的文件让字符串越界
+            item.food_type[99] = '\0';
+            if (!food_store_pack(s, &s->items[i], &item)) return 0;
+        }
+    } else if (!load_freezer_records(s, &h, data + freezer_header_size(&h))) {
+        return 0;
+    }
+    adopt_loaded_records(s, n);
+    load_freezer_header(f, &h);
+    return 1;
+}
+
+/*
+ * 函数：load_freezer_from_binary
+ * 功能：读取二进制冰柜文件，POSIX下映射整个文件，不经过stdio缓冲
+ * 参数：filepath - 二进制文件路径
+ * 参数：f - 指向冰柜结构体的指针
+ * 返回：成功返回1，文件损坏或读取失败返回0
+ */
+int load_freezer_from_binary(const char* filepath, frezzer* f) {
+    frezzer_reset(f);
+#ifdef _WIN32
+    FILE* fp = fopen(filepath, "rb");
+    if (fp == NULL) return 0;
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    char* data = size > 0 ? (char*)malloc((size_t)size) : NULL;
+    int ok = data != NULL && fread(data, 1, (size_t)size, fp) == (size_t)size && load_freezer_image(f, data, (size_t)size);
+    stats_count(STATS_BYTES_READ, size);
+    free(data);
+    fclose(fp);
+#else
+    int fd = open(filepath, O_RDONLY);
+    if (fd == -1) return 0;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        return 0;
+    }
+    void* map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return 0;
+    int ok = load_freezer_image(f, (const char*)map, (size_t)st.st_size);
+    stats_count(STATS_BYTES_READ, (long long)st.st_size);
+    munmap(map, (size_t)st.st_size);
+#endif
+    if (!ok) {
+        frezzer_reset(f);
+        return 0;
+    }
+    return 1;
+}
+
+/*
+ * 函数：save_freezer_to_binary
+ * 功能：把冰柜写成版本2的二进制文件；种类只写本冰柜用到的并重新编号，长名称按显示顺序重新排进溢出区（丢掉删改留下的空间）；先写临时文件再改名，写到一半失败也不会破坏原文件
+ * 参数：filepath - 二进制文件路径
+ * 参数：f - 指向冰柜结构体的指针
+ * 返回：成功返回1，失败返回0
+ */
+int save_freezer_to_binary(const char* filepath, frezzer* f) {
+    const food_store* s = &f->store;
+    int dictionary_count = atomic_load(&food_types.count);
+    uint16_t* local_id = (uint16_t*)malloc(((size_t)dictionary_count + 1) * sizeof(uint16_t));  // 字典编号 -> 文件中的编号
+    uint16_t* file_types = (uint16_t*)malloc(((size_t)dictionary_count + 1) * sizeof(uint16_t));  // 文件中的编号 -> 字典编号
+    if (local_id == NULL || file_types == NULL) {
+        free(local_id);
+        free(file_types);
+        return 0;
+    }
+    memset(local_id, 0xFF, (size_t)dictionary_count * sizeof(uint16_t));
+
+    freezer_file_header h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, "FRZB", 4);
+    h.version = 3;
+    h.record_size = sizeof(food_record);
+    h.count = (uint32_t)s->count;
+    h.available_volume = f->frezzer_available_volume;
+    h.temperature = f->frezzer_temperature;
+    h.temp_below_range = f->temp_below_range;
+    if (FREZZER_TEMP_RANGE == 31) memcpy(h.temp_histogram, f->temp_histogram, sizeof(h.temp_histogram));
+    h.capacity = FREZZER_CAPACITY;
+    h.temp_min = FREZZER_TEMP_MIN;
+    h.temp_max = FREZZER_TEMP_MAX;
+    for (int i = s->first; i != -1; i = s->links[i].next) {  // 1. 先统计用到的种类和长名称的总长度
+        const food_record* r = &s->items[i];
+        if (local_id[r->type_id] == FOOD_TYPE_NONE) {
+            local_id[r->type_id] = (uint16_t)h.type_count;
+            file_types[h.type_count++] = r->type_id;
+            h.type_bytes += (uint32_t)strlen(food_type_name(r->type_id)) + 1;
+        }
+        if (food_record_spilled(r)) h.spill_bytes += (uint32_t)strlen(food_record_name(s, r)) + 1;
+    }
+
+    char temp_path[610];
+    sprintf(temp_path, "%s.tmp", filepath);
+    FILE* fp = fopen(temp_path, "wb");
+    int ok = fp != NULL && fwrite(&h, sizeof(h), 1, fp) == 1;
+    uint32_t spill_offset = 0;
+    for (int i = s->first; ok && i != -1; i = s->links[i].next) {  // 2. 按显示顺序写入记录，读取时不用再排序
+        food_record r = s->items[i];
+        r.type_id = local_id[r.type_id];
+        if (food_record_spilled(&r)) {
+            uint32_t length = (uint32_t)strlen(food_record_name(s, &s->items[i]));
+            food_record_set_spill_ref(&r, spill_offset, length);
+            spill_offset += length + 1;
+        }
+        ok = fwrite(&r, sizeof(r), 1, fp) == 1;
+    }
+    for (uint32_t t = 0; ok && t < h.type_count; t++) {  // 3. 种类表
+        const char* name = food_type_name(file_types[t]);
+        ok = fwrite(name, strlen(name) + 1, 1, fp) == 1;
+    }
+    for (int i = s->first; ok && i != -1; i = s->links[i].next) {  // 4. 溢出区，顺序与第2步分配的偏移一致
+        if (!food_record_spilled(&s->items[i])) continue;
+        const char* name = food_record_name(s, &s->items[i]);
+        ok = fwrite(name, strlen(name) + 1, 1, fp) == 1;
+    }
+    free(local_id);
+    free(file_types);
+    if (fp != NULL) stats_count(STATS_BYTES_WRITTEN, ftell(fp));
+    if (fp != NULL && fclose(fp) != 0) ok = 0;
+    if (!ok) {
+        remove(temp_path);
+        return 0;
+    }
+#ifdef _WIN32
+    remove(filepath);  // Windows下rename不能覆盖已存在的文件
+#endif
+    if (rename(temp_path, filepath) != 0) {
+        remove(temp_path);
+        return 0;
+    }
+    return 1;
+}
+
+int save_freezer_to_file(const char* filepath, frezzer* f) {  // 保存冰柜，传入：冰柜的文本文件路径（xxx.txt） 指向冰柜结构体的指针 默认存成二进制并删掉旧的文本文件（自动转换），成功返回1
+    if (f->load_errors > 0) {  // 读取时跳过了行：重写会把这些行丢掉
+        printf("Error: %s has %d unreadable row(s), not overwriting it\n", filepath, f->load_errors);
+        return 0;
+    }
+    double start = stats_start();
+    char binary_path[610];
+    freezer_binary_path(filepath, binary_path);
+    int ok;
+    if (!freezer_binary_format) {  // 使用文本格式时删掉旧的二进制文件，以免读到过期数据
+        ok = save_freezer_to_text(filepath, f);
+        if (ok) remove(binary_path);
+    } else {
+        ok = save_freezer_to_binary(binary_path, f);
+        if (ok) remove(filepath);
+        else printf("Error: Cannot save file %s\n", binary_path);
+    }
+    stats_stop(STATS_TIMER_SAVE, start);
+    return ok;
+}
+
+void freezer_journal_path(const char* text_path, char* out) {  // 由 xxx.txt 得到日志文件路径 xxx.journal
+    strcpy(out, text_path);
+    char* dot = strrchr(out, '.');
+    if (dot && strcmp(dot, ".txt") == 0) strcpy(dot, ".journal");
+    else strcat(out, ".journal");
+}
+
+int freezer_journal_stat(const char* text_path, struct stat* st) {  // 取冰柜日志文件的状态，没有日志返回0
+    char path[610];
+    freezer_journal_path(text_path, path);
+    return stat_file(path, st) == 0;
+}
+
+void freezer_lock_path(const char* text_path, char* out) {  // 由 xxx.txt 得到锁文件路径 xxx.lock
+    strcpy(out, text_path);
+    char* dot = strrchr(out, '.');
+    if (dot && strcmp(dot, ".txt") == 0) strcpy(dot, ".lock");
+    else strcat(out, ".lock");
+}
+
+/*
+ * 函数：freezer_lock
+ * 功能：对冰柜加独占的建议锁（锁文件 xxx.lock），一直等到拿到为止
+ *       所有写冰柜文件的操作（追加日志、整理、批处理、新建、删除）都先加锁；只读的列表和查看不加锁，
+ *       它们读到的是改名替换后的完整基础文件加上校验过的日志记录
+ *       锁文件不随冰柜删除，否则正在等锁的进程和新来的进程会锁在两个不同的文件上
+ * 参数：text_path - 冰柜的文本文件路径
+ * 返回：锁文件的描述符，传给 freezer_unlock；打不开锁文件时返回-1，此时不加锁继续
+ */
+int freezer_lock(const char* text_path) {
+    char path[610];
+    freezer_lock_path(text_path, path);
+#ifdef _WIN32
+    int fd = _open(path, _O_RDWR | _O_CREAT, _S_IREAD | _S_IWRITE);
+    if (fd == -1) return -1;
+    for (; _locking(fd, _LK_LOCK, 1) != 0 && errno == EDEADLOCK; );  // _LK_LOCK 每秒重试一次，10次后失败，接着再等
+#else
+    int fd = open(path, O_RDWR | O_CREAT, 0666);
+    if (fd == -1) return -1;
+    for (; flock(fd, LOCK_EX) != 0 && errno == EINTR; );
+#endif
+    return fd;
+}
+
+void freezer_unlock(int fd) {  // 释放 freezer_lock 加的锁
+    if (fd == -1) return;
+#ifdef _WIN32
+    _lseek(fd, 0, SEEK_SET);
+    _locking(fd, _LK_UNLCK, 1);
+    _close(fd);
+#else
+    flock(fd, LOCK_UN);
+    close(fd);
+#endif
+}
+
+int freezer_base_stat(const char* text_path, struct stat* st) {  // 取冰柜实际读取的基础文件（二进制或文本）的状态，不存在返回0
+    char binary_path[610];
+    const char* path = freezer_uses_binary(text_path, binary_path) ? binary_path : text_path;
+    return stat_file(path, st) == 0;
+}
+
+/*
+ * 函数：journal_header
+ * 功能：生成日志的第一行：记下日志是接在哪个基础文件之后的（大小和修改时间）
+ *       整理时基础文件被替换，旧日志的第一行就对不上了，之后会被忽略，不会重复重放
+ * 参数：text_path - 冰柜的文本文件路径
+ * 参数：out - 输出第一行的内容（不含校验值）
+ * 返回：基础文件存在返回1，否则返回0
+ */
+int journal_header(const char* text_path, char* out) {
+    struct stat st;
+    if (!freezer_base_stat(text_path, &st)) return 0;
+    sprintf(out, "FRZJ %lld %lld", (long long)st.st_size, stat_mtime_ns(&st));
+    return 1;
+}
+
+int journal_line_valid(char* line) {  // 检查一行日志：以换行结尾且校验值正确，通过后去掉换行和校验值，只留下内容
+    size_t len = strlen(line);
+    if (len == 0 || line[len - 1] != '\n') return 0;  // 崩溃时只写了一半的记录
+    line[len - 1] = '\0';
+    char* space = strrchr(line, ' ');
+    if (space == NULL) return 0;
+    char* end;
+    unsigned long checksum = strtoul(space + 1, &end, 16);
+    if (end == space + 1 || *end != '\0') return 0;
+    *space = '\0';
+    return (uint32_t)checksum == hash_string(line);
+}
+
+int journal_find(const frezzer* f, const food* item) {  // 日志按内容指明食物：找名称、种类、体积、温度都相同的食物，返回槽位号，找不到返回-1
+    uint16_t type_id = food_type_find(item->food_type);
+    for (int i = food_store_find_name(&f->store, -1, item->food_name); i != -1; i = food_store_find_name(&f->store, i, item->food_name)) {
+        const food_record* r = &f->store.items[i];
+        if (r->type_id == type_id && r->volume == item->food_volume && r->temperature == item->food_temperature) return i;
+    }
+    return -1;
+}
+
+/*
+ * 函数：replay_freezer_journal
+ * 功能：把日志中的修改依次重放到刚读入的冰柜上；日志不属于当前基础文件时忽略
+ * 参数：text_path - 冰柜的文本文件路径
+ * 参数：f - 指向已读入基础文件的冰柜结构体的指针
+ * 返回：日志中的有效记录数
+ */
+int replay_freezer_journal(const char* text_path, frezzer* f) {
+    char path[610], header[128], line[1024];
+    freezer_journal_path(text_path, path);
+    FILE* fp = fopen(path, "r");
+    if (fp == NULL) return 0;
+    int records = 0;
+    if (journal_header(text_path, header) && fgets(line, sizeof(line), fp) != NULL
+        && journal_line_valid(line) && strcmp(line, header) == 0) {
+        for (; fgets(line, sizeof(line), fp) != NULL; ) {
+            stats_count(STATS_BYTES_READ, (long long)strlen(line));
+            if (!journal_line_valid(line)) continue;  // 跳过崩溃留下的半条记录
+            char op;
+            food a, b;  // 添加、删除的食物，或修改前(a)、修改后(b)的食物
+            int n = sscanf(line, "%c %99s %99s %d %d %99s %99s %d %d", &op, a.food_name, a.food_type, &a.food_volume, &a.food_temperature,
+                           b.food_name, b.food_type, &b.food_volume, &b.food_temperature);
+            if (op == 'A' && n == 5) {
+                frezzer_add_food(f, &a);
+            } else if (op == 'D' && n == 5) {
+                int slot = journal_find(f, &a);
+                if (slot != -1) frezzer_remove_food(f, slot);
+            } else if (op == 'M' && n == 9) {
+                int slot = journal_find(f, &a);
+                if (slot != -1) frezzer_update_food(f, slot, &b);
+            } else {
+                continue;
+            }
+            records++;
+        }
+    }
+    fclose(fp);
+    return records;
+}
+
+void sync_file(FILE* fp) {  // 把文件内容真正写到磁盘上
+    fflush(fp);
+#ifdef _WIN32
+    _commit(_fileno(fp));
+#else
+    fsync(fileno(fp));
+#endif
+}
+
+int journal_write_line(freezer_journal* j, const char* content) {  // 写一行日志（内容 + 校验值），按落盘策略决定是否立即落盘，成功返回1
+    int written = fprintf(j->fp, "%s %08x\n", content, (unsigned)hash_string(content));
+    if (written < 0 || fflush(j->fp) != 0) return 0;
+    stats_count(STATS_BYTES_WRITTEN, written);
+    if (journal_fsync_policy == JOURNAL_FSYNC_ALWAYS) sync_file(j->fp);
+    return 1;
+}
+
+/*
+ * 函数：journal_open
+ * 功能：打开冰柜时记下基础文件对应的日志第一行和日志的大小，准备记日志；日志文件要到第一次修改时才打开或新建
+ *       只查看不修改时不碰日志文件，仓库的摘要缓存、列式快照和后台模型都不会因此失效
+ * 参数：j - 日志
+ * 参数：text_path - 冰柜的文本文件路径（冰柜须已存在）
+ * 参数：records - 读取冰柜时重放的日志记录数
+ * 返回：成功返回1，失败返回0
+ */
+int journal_open(freezer_journal* j, const char* text_path, int records) {
+    struct stat st;
+    j->fp = NULL;
+    j->active = 0;
+    j->records = records;
+    j->header[0] = '\0';
+    j->size = freezer_journal_stat(text_path, &st) ? (long long)st.st_size : -1;
+    if (!journal_header(text_path, j->header)) return 0;
+    j->active = 1;
+    return 1;
+}
+
+int journal_create(freezer_journal* j, const char* text_path) {  // 第一次修改时打开日志准备追加；没有日志或日志已过期时新建（须已加锁，且刚检查过没有别的进程改过），成功返回1
+    char path[610], line[1024];
+    freezer_journal_path(text_path, path);
+    FILE* fp = fopen(path, "r");
+    int valid = fp != NULL && fgets(line, sizeof(line), fp) != NULL && journal_line_valid(line) && strcmp(line, j->header) == 0;
+    if (fp != NULL) fclose(fp);
+    if (!valid) {  // 从头开始一个新日志
+        j->records = 0;
+        j->fp = fopen(path, "w");
+        if (j->fp == NULL) return 0;
+        if (!journal_write_line(j, j->header)) {
+            fclose(j->fp);
+            j->fp = NULL;
+            return 0;
+        }
+        j->size = ftell(j->fp);
+        return 1;
+    }
+
+    j->fp = fopen(path, "a+");
+    if (j->fp == NULL) return 0;
+    fseek(j->fp, -1, SEEK_END);
+    int last = fgetc(j->fp);
+    fseek(j->fp, 0, SEEK_END);
+    if (last != '\n' && (fputc('\n', j->fp) == EOF || fflush(j->fp) != 0)) {  // 上次崩溃留下半条记录：先补上换行，让新记录从新的一行开始
+        fclose(j->fp);
+        j->fp = NULL;
+        return 0;
+    }
+    j->size = ftell(j->fp);
+    return 1;
+}
+
+/*
+ * 函数：journal_changed
+ * 功能：乐观检查：自本进程上次读写以来，冰柜是否被别的进程改过
+ *       基础文件被替换（日志第一行对不上）或日志大小变了（有人追加了记录）都算改过
+ * 参数：j - 日志（打开时记下了第一行和大小）
+ * 参数：text_path - 冰柜的文本文件路径
+ * 返回：改过返回1，没有返回0
+ */
+int journal_changed(const freezer_journal* j, const char* text_path) {
+    char header[128];
+    struct stat st;
+    if (!journal_header(text_path, header) || strcmp(header, j->header) != 0) return 1;
+    long long size = freezer_journal_stat(text_path, &st) ? (long long)st.st_size : -1;
+    return size != j->size;
+}
+
+/*
+ * 函数：journal_append
+ * 功能：追加一条修改记录：A 添加（a），D 删除（a），M 把a修改为b；这是第一次修改时先打开或新建日志文件
+ * 参数：j - 已打开的日志
+ * 参数：text_path - 冰柜的文本文件路径
+ * 参数：op - 'A'、'D' 或 'M'
+ * 参数：a - 添加或删除的食物，或修改前的食物
+ * 参数：b - 修改后的食物，其他操作传NULL
+ * 返回：成功返回1，失败返回0（写入失败时关闭日志，离开冰柜时改为整体保存）
+ */
+int journal_append(freezer_journal* j, const char* text_path, char op, const food* a, const food* b) {
+    if (!j->active) return 0;
+    char content[1024];
+    int n = sprintf(content, "%c %s %s %d %d", op, a->food_name, a->food_type, a->food_volume, a->food_temperature);
+    if (b != NULL) sprintf(content + n, " %s %s %d %d", b->food_name, b->food_type, b->food_volume, b->food_temperature);
+    if ((j->fp == NULL && !journal_create(j, text_path)) || !journal_write_line(j, content)) {
+        printf("Warning: Cannot write journal, changes will be saved on return.\n");
+        if (j->fp != NULL) fclose(j->fp);
+        j->fp = NULL;
+        j->active = 0;
+        return 0;
+    }
+    j->records++;
+    j->size = ftell(j->fp);
+    return 1;
+}
+
+void journal_close(freezer_journal* j, const char* text_path) {  // 关闭日志，按落盘策略落盘；没有任何记录、别的进程也没有追加时删掉日志文件（须已加锁）
+    j->active = 0;
+    if (j->fp == NULL) return;  // 没有修改过，日志文件没有碰过
+    if (journal_fsync_policy != JOURNAL_FSYNC_NEVER) sync_file(j->fp);
+    fclose(j->fp);
+    j->fp = NULL;
+    if (j->records == 0 && !journal_changed(j, text_path)) {
+        char path[610];
+        freezer_journal_path(text_path, path);
+        if (remove(path) == 0) j->size = -1;
+    }
+}
+
+void load_freezer_base(const char* filepath, frezzer* f) {  // 只读取冰柜的基础文件：有较新的二进制文件时直接映射读取，否则解析文本
+    char binary_path[610];
+    if (freezer_uses_binary(filepath, binary_path)) {
+        if (load_freezer_from_binary(binary_path, f)) return;
+        load_warning("Error: Damaged freezer file %s\n", binary_path);
+    }
+    load_freezer_from_text(filepath, f);
+}
+
+/*
+ * 函数：load_freezer_from_file
+ * 功能：读取冰柜：先读基础文件，再重放日志；读的过程中后台整理恰好替换了基础文件时重读
+ * 参数：filepath - 冰柜的文本文件路径（xxx.txt）
+ * 参数：f - 指向已初始化的冰柜结构体的指针
+ * 返回：重放的日志记录数
+ */
+int load_freezer_from_file(const char* filepath, frezzer* f) {
+    double start = stats_start();
+    int records = 0;
+    for (int attempt = 0; attempt < 3; attempt++) {
+        struct stat before, after;
+        int has_base = freezer_base_stat(filepath, &before);
+        load_freezer_base(filepath, f);
+        records = replay_freezer_journal(filepath, f);
+        if (!has_base || !freezer_base_stat(filepath, &after)) break;
+        if (before.st_size == after.st_size && stat_mtime_ns(&before) == stat_mtime_ns(&after)) break;
+    }
+    stats_stop(STATS_TIMER_LOAD, start);
+    return records;
+}
+
+/*
+ * 函数：journal_sync
+ * 功能：加锁后、修改冰柜之前调用：别的进程改过这个冰柜时重新读取基础文件和日志，把对方的修改合并进来
+ *       之后本进程的修改再按内容核对、追加到同一个日志上；不记日志（整体保存）时内存中的修改不能丢，不重新读取
+ * 参数：j - 日志
+ * 参数：text_path - 冰柜的文本文件路径
+ * 参数：f - 当前打开的冰柜
+ * 返回：重新读取了返回1，否则返回0
+ */
+int journal_sync(freezer_journal* j, const char* text_path, frezzer* f) {
+    if (!j->active || !journal_changed(j, text_path)) return 0;
+    if (j->fp != NULL) fclose(j->fp);
+    j->fp = NULL;
+    int records = load_freezer_from_file(text_path, f);
+    if (!journal_open(j, text_path, records)) printf("Warning: Cannot open journal, changes will be saved on return.\n");
+    return 1;
+}
+
+int freezer_edit_begin(freezer_journal* j, const char* text_path, frezzer* f) {  // 修改食物之前：加锁并合并别的进程的修改，返回锁（改完交给 freezer_unlock）
+    int lock = freezer_lock(text_path);
+    if (journal_sync(j, text_path, f)) printf("Note: Freezer was changed by another session, reloaded.\n");
+    return lock;
+}
+
+// 结构体：后台整理任务：把冰柜（基础文件+日志）重新写成一个基础文件，再删掉日志
+typedef struct freezer_compaction {
+    pthread_t thread;
+    int active;  // 是否有整理线程还没有被等待（只由主线程读写）
+    char path[600];  // 冰柜的文本文件路径
+    freezer_journal journal;  // 交出冰柜时日志的状态（第一行和大小），用来判断之后别的进程有没有改过
+    frezzer f;  // 要写出的冰柜，写完只清空，内存留给之后打开的冰柜复用
+} freezer_compaction;
+
+freezer_compaction compaction;  // 全局变量：同一时间最多一个后台整理任务
+
+void* compaction_main(void* arg) {  // 整理线程：加锁后先用临时文件+改名替换基础文件，成功后再删日志（替换后日志已过期，即使来不及删也不会被重放）
+    freezer_compaction* c = (freezer_compaction*)arg;
+    int lock = freezer_lock(c->path);
+    if (journal_changed(&c->journal, c->path)) load_freezer_from_file(c->path, &c->f);  // 交出之后别的进程又改过：按文件重新读取，不能用手里的旧内容覆盖
+    if (save_freezer_to_file(c->path, &c->f)) {
+        char path[610];
+        freezer_journal_path(c->path, path);
+        remove(path);
+    }
+    freezer_unlock(lock);
+    frezzer_reset(&c->f);
+    return NULL;
+}
+
+void freezer_compaction_wait() {  // 等待后台整理结束；修改、删除冰柜文件之前，以及退出程序之前调用
+    if (compaction.active) {
+        pthread_join(compaction.thread, NULL);
+        compaction.active = 0;
+    }
+}
+
+/*
+ * 函数：freezer_compaction_start
+ * 功能：把冰柜交给后台线程写成新的基础文件；冰柜结构体与整理任务中的空冰柜交换，不复制数据
+ * 参数：text_path - 冰柜的文本文件路径
+ * 参数：f - 指向冰柜结构体的指针，返回时为空冰柜
+ * 参数：j - 已关闭的日志
+ */
+void freezer_compaction_start(const char* text_path, frezzer* f, const freezer_journal* j) {
+    freezer_compaction_wait();
+    frezzer temp = compaction.f;
+    compaction.f = *f;
+    *f = temp;
+    compaction.journal = *j;
+    strcpy(compaction.path, text_path);
+    if (pthread_create(&compaction.thread, NULL, compaction_main, &compaction) == 0) compaction.active = 1;
+    else compaction_main(&compaction);  // 创建线程失败时直接在当前线程整理
+}
+
+// 结构体：最近关闭的冰柜留在内存中，再次打开时只要文件没变（日志第一行和大小都对得上）就不用重新读取
+typedef struct freezer_cache {
+    int valid;  // 是否存着冰柜
+    char path[600];  // 冰柜的文本文件路径
+    freezer_journal journal;  // 关闭时日志的状态
+    frezzer f;
+} freezer_cache;
+
+freezer_cache recent_freezer;  // 全局变量：最近关闭的一个冰柜
+
+void freezer_cache_put(const char* text_path, frezzer* f, const freezer_journal* j) {  // 留下刚关闭的冰柜：与缓存中的冰柜结构体交换，f 得到旧的缓存内容（由调用者清空）
+    frezzer temp = recent_freezer.f;
+    recent_freezer.f = *f;
+    *f = temp;
+    recent_freezer.journal = *j;
+    strcpy(recent_freezer.path, text_path);
+    recent_freezer.valid = 1;
+}
+
+int freezer_cache_take(const char* text_path, frezzer* f) {  // 要打开的冰柜就是最近关闭的那个且文件没变时直接换回来，返回日志记录数；否则返回-1
+    if (!recent_freezer.valid || strcmp(recent_freezer.path, text_path) != 0 || journal_changed(&recent_freezer.journal, text_path)) return -1;
+    frezzer temp = *f;
+    *f = recent_freezer.f;
+    recent_freezer.f = temp;
+    recent_freezer.valid = 0;
+    return recent_freezer.journal.records;
+}
+
+int freezer_exists(const char* text_path) {  // 冰柜的文本文件或二进制文件任意一个存在即可
+    char binary_path[610];
+    struct stat temp;
+    freezer_binary_path(text_path, binary_path);
+    return stat_file(text_path, &temp) == 0 || stat_file(binary_path, &temp) == 0;
+}
+
+// 结构体：一个冰柜的摘要（仓库列表只需要这些），连同文件的修改时间和大小一起缓存
+typedef struct freezer_summary {
+    char file_name[256];  // 冰柜文件名（不含目录），如 frezzer1.frz
+    long long mtime;  // 文件修改时间（纳秒，平台不支持时精确到秒）
+    long long size;  // 文件大小
+    int temperature;  // 冰柜温度
+    int available_volume;  // 冰柜可用容积
+} freezer_summary;
+
+// 结构体：仓库的摘要缓存，对应仓库目录下的 freezers.idx
+typedef struct summary_cache {
+    freezer_summary* items;  // 按文件名排好序，便于二分查找
+    int count;
+    int capacity;
+} summary_cache;
+
+freezer_summary* summary_cache_add(summary_cache* c) {  // 在缓存末尾追加一条，返回其指针，失败返回NULL
+    if (c->count == c->capacity) {
+        int new_capacity = c->capacity ? c->capacity * 2 : 16;
+        freezer_summary* temp = (freezer_summary*)realloc(c->items, (size_t)new_capacity * sizeof(freezer_summary));
+        if (temp == NULL) return NULL;
+        c->items = temp;
+        c->capacity = new_capacity;
+    }
+    return &c->items[c->count++];
+}
+
+int summary_cmp(const void* a, const void* b) {  // 按文件名排序
+    return strcmp(((const freezer_summary*)a)->file_name, ((const freezer_summary*)b)->file_name);
+}
+
+void summary_cache_load(const char* warehouse_path, summary_cache* c) {  // 读取仓库的摘要缓存文件，文件不存在时得到空缓存
+    c->items = NULL;
+    c->count = c->capacity = 0;
+    char path[620];
+    sprintf(path, "%s/freezers.idx", warehouse_path);
+    FILE* fp = fopen(path, "r");
+    if (fp == NULL) return;
+
+    // 第一行记录写缓存时的容量和温度范围（没有这一行的旧缓存按100、-20、10），与当前编译的不同时缓存作废
+    int capacity = 100, temp_min = -20, temp_max = 10;
+    if (fscanf(fp, " #policy %d %d %d", &capacity, &temp_min, &temp_max) != 3) rewind(fp);
+    if (capacity != FREZZER_CAPACITY || temp_min != FREZZER_TEMP_MIN || temp_max != FREZZER_TEMP_MAX) {
+        fclose(fp);
+        return;
+    }
+    freezer_summary temp;  // 每行：文件名 修改时间 大小 温度 可用容积
+    for (; fscanf(fp, "%255s %lld %lld %d %d", temp.file_name, &temp.mtime, &temp.size, &temp.temperature, &temp.available_volume) == 5; ) {
+        freezer_summary* slot = summary_cache_add(c);
+        if (slot == NULL) break;
+        *slot = temp;
+    }
+    stats_count(STATS_BYTES_READ, ftell(fp));
+    fclose(fp);
+    qsort(c->items, c->count, sizeof(freezer_summary), summary_cmp);
+}
+
+/*
+ * 函数：open_unique_temp
+ * 功能：在目标文件旁边新建一个名字唯一的临时文件（path.XXXXXX），不加锁的写者（别的进程、后台线程）各写各的，
+ *       改名时整体替换，不会写进同一个临时文件
+ * 参数：path - 目标文件路径
+ * 参数：temp_path - 输出临时文件路径（至少比 path 长8字节）
+ * 参数：mode - 打开方式，"w" 或 "wb"
+ * 返回：打开的文件，失败返回NULL
+ */
+FILE* open_unique_temp(const char* path, char* temp_path, const char* mode) {
+    sprintf(temp_path, "%s.XXXXXX", path);
+#ifndef _WIN32
+    int fd = mkstemp(temp_path);
+    if (fd == -1) return NULL;
+    fchmod(fd, 0644);  // mkstemp 建出的文件只有自己能读
+    FILE* fp = fdopen(fd, mode);
+    if (fp == NULL) {
+        close(fd);
+        remove(temp_path);
+    }
+    return fp;
+#else
+    if (_mktemp(temp_path) == NULL) return NULL;
+    return fopen(temp_path, strcmp(mode, "wb") == 0 ? "wbx" : "wx");  // x：文件已存在时失败，不会和别人共用
+#endif
+}
+
+void summary_cache_save(const char* warehouse_path, const summary_cache* c) {  // 写回摘要缓存（先写唯一的临时文件再改名）
+    char path[620], temp_path[630];
+    sprintf(path, "%s/freezers.idx", warehouse_path);
+    FILE* fp = open_unique_temp(path, temp_path, "w");
+    if (fp == NULL) return;
+    fprintf(fp, "#policy %d %d %d\n", FREZZER_CAPACITY, FREZZER_TEMP_MIN, FREZZER_TEMP_MAX);
+    for (int i = 0; i < c->count; i++) {
+        const freezer_summary* e = &c->items[i];
+        fprintf(fp, "%s %lld %lld %d %d\n", e->file_name, e->mtime, e->size, e->temperature, e->available_volume);
+    }
+    stats_count(STATS_BYTES_WRITTEN, ftell(fp));
+    if (fclose(fp) != 0) {
+        remove(temp_path);
+        return;
+    }
+#ifdef _WIN32
+    remove(path);
+#endif
+    if (rename(temp_path, path) != 0) remove(temp_path);
+}
+
+const freezer_summary* summary_cache_find(const summary_cache* c, const char* file_name) {  // 二分查找某个冰柜文件的缓存，没有返回NULL
+    freezer_summary key;
+    strncpy(key.file_name, file_name, sizeof(key.file_name) - 1);
+    key.file_name[sizeof(key.file_name) - 1] = '\0';
+    return (const freezer_summary*)bsearch(&key, c->items, c->count, sizeof(freezer_summary), summary_cmp);
+}
+
+/*
+ * 函数：read_freezer_summary
+ * 功能：计算一个冰柜的温度和可用容积；没有日志的二进制文件只读文件头，其余情况需要完整读取
+ * 参数：filepath - 实际的冰柜文件路径（.frz 或 .txt）
+ * 参数：text_path - 冰柜的文本文件路径
+ * 参数：e - 输出摘要（没有日志时e->size就是文件大小）
+ */
+void read_freezer_summary(const char* filepath, char* text_path, freezer_summary* e) {
+    const char* dot = strrchr(filepath, '.');
+    struct stat journal;
+    if (dot && strcmp(dot, ".frz") == 0 && !freezer_journal_stat(text_path, &journal)) {
+        FILE* fp = fopen(filepath, "rb");
+        freezer_file_header h;
+        char head[sizeof(h)];  // 版本1的文件头较短，按实际读到的字节数解析
+        size_t got = fp != NULL ? fread(head, 1, sizeof(head), fp) : 0;
+        stats_count(STATS_BYTES_READ, (long long)got);
+        int ok = freezer_read_header(&h, head, got) && freezer_header_valid(&h, (size_t)e->size) && freezer_header_policy_matches(&h);
+        if (fp != NULL) fclose(fp);
+        if (ok) {
+            e->temperature = h.temperature;
+            e->available_volume = h.available_volume;
+            return;
+        }
+    }
+    frezzer f;  // 文本文件、有日志，或二进制文件损坏时退回完整读取
+    frezzer_init(&f);
+    load_freezer_from_file(text_path, &f);
+    e->temperature = f.frezzer_temperature;
+    e->available_volume = f.frezzer_available_volume;
+    frezzer_free(&f);  // 只要摘要，读完就释放
+}
+
+/*
+ * 函数：scan_warehouse_freezers
+ * 功能：列出仓库中的冰柜文件，只看目录和文件属性不读内容；规则与仓库列表一致
+ * 参数：warehouse_path - 仓库路径
+ * 参数：c - 输出，只填文件名、修改时间和大小（有日志时算上日志），按文件名排好序（用完由调用者释放 c->items）
+ * 返回：仓库能打开返回1，否则返回0
+ */
+int scan_warehouse_freezers(const char* warehouse_path, summary_cache* c) {
+    c->items = NULL;
+    c->count = c->capacity = 0;
+    DIR *dir = opendir(warehouse_path); // 打开目标仓库的文件夹
+    if (dir == NULL) return 0;
+
+    struct dirent *entry;  // 指向目录项的指针
+    for (entry = readdir(dir); entry != NULL; entry = readdir(dir)) {  // 遍历目标仓库的文件夹中的所有文件，直到下一个是null
+        struct stat temp;
+        char path[600];
+        sprintf(path, "%s/%s", warehouse_path, entry->d_name);  // 拼出完整的文件路径
+        if (stat_file(path, &temp) == 0 && S_ISREG(temp.st_mode)) {  // 判断文件是否存在，并检查是否为普通文件
+            char *dot = strrchr(path, '.');  // 检查后缀名是否为 .txt 或 .frz，dot指向这个位置
+            if (dot && (strcmp(dot, ".txt") == 0 || strcmp(dot, ".frz") == 0)) {
+                int is_binary = strcmp(dot, ".frz") == 0;
+                char text_path[600], binary_path[610];
+                strcpy(text_path, path);
+                strcpy(text_path + (dot - path), ".txt");  // 冰柜的文本文件路径
+                if (freezer_uses_binary(text_path, binary_path) != is_binary) continue;  // 同一个冰柜两种文件都在时只列出实际读取的那个
+
+                long long mtime = stat_mtime_ns(&temp), size = (long long)temp.st_size;
+                struct stat journal;  // 有日志时日志的改动也算在内：取较新的修改时间，大小相加（日志只在真正修改时才会出现，只查看冰柜不会让缓存失效）
+                if (freezer_journal_stat(text_path, &journal)) {
+                    if (stat_mtime_ns(&journal) > mtime) mtime = stat_mtime_ns(&journal);
+                    size += (long long)journal.st_size;
+                }
+
+                freezer_summary* e = summary_cache_add(c);
+                if (e == NULL) break;
+                memset(e, 0, sizeof(*e));
+                memcpy(e->file_name, entry->d_name, strnlen(entry->d_name, sizeof(e->file_name) - 1));
+                e->mtime = mtime;
+                e->size = size;
+            }
+        }
+    }
+    closedir(dir);  // 关闭目标仓库的文件夹
+    qsort(c->items, c->count, sizeof(freezer_summary), summary_cmp);
+    return 1;
+}
+
+void freezer_entry_paths(const char* warehouse_path, const char* file_name, char* path, char* text_path) {  // 由仓库路径和冰柜文件名拼出文件路径和冰柜的文本文件路径
+    sprintf(path, "%s/%s", warehouse_path, file_name);
+    strcpy(text_path, path);
+    strcpy(strrchr(text_path, '.'), ".txt");
+}
+
+/*
+ * 函数：load_warehouse_summaries
+ * 功能：取仓库中所有冰柜的摘要（温度、可用容积），文件没变的冰柜直接用缓存，只有改动过的冰柜才重新读取；有变化时写回缓存
+ * 参数：warehouse_path - 仓库路径
+ * 参数：c - 输出的摘要，按文件名排好序（用完由调用者释放 c->items）
+ * 返回：仓库能打开返回1，否则返回0
+ */
+int load_warehouse_summaries(const char* warehouse_path, summary_cache* c) {
+    double start = stats_start();
+    if (!scan_warehouse_freezers(warehouse_path, c)) return 0;
+    summary_cache old_cache;  // 上次保存的缓存
+    summary_cache_load(warehouse_path, &old_cache);
+    int changed = 0;  // 有没有冰柜需要重新读取
+
+    for (int i = 0; i < c->count; i++) {
+        freezer_summary* e = &c->items[i];
+        const freezer_summary* cached = summary_cache_find(&old_cache, e->file_name);
+        if (cached != NULL && cached->mtime == e->mtime && cached->size == e->size) {
+            *e = *cached;  // 文件没变，直接用缓存
+        } else {
+            char path[600], text_path[600];
+            freezer_entry_paths(warehouse_path, e->file_name, path, text_path);
+            read_freezer_summary(path, text_path, e);
+            changed = 1;
+        }
+    }
+
+    if (changed || c->count != old_cache.count) summary_cache_save(warehouse_path, c);  // 有变化时才写回缓存
+    free(old_cache.items);
+    stats_stop(STATS_TIMER_SCAN, start);
+    return 1;
+}
+
+// 结构体：内存中的一个仓库，冰柜摘要常驻内存，收到文件变化通知时才重新读取
+typedef struct warehouse_entry {
+    char name[256];  // 仓库目录名，如 warehouse_1
+    int watch;  // inotify 监视描述符，-1表示没有监视
+    int stale;  // 冰柜文件变过（或还没读过），摘要需要重新读取
+    int loading;  // 正有一个线程在读这个仓库（已放开锁），摘要还是旧的或空的；读完时广播 model.loaded
+    int seen;  // 重新列出仓库时是否还在
+    summary_cache summaries;  // 冰柜摘要，按文件名排好序
+    char* notes;  // 后台读取时攒下的警告，主线程显示这个仓库时打印并释放，NULL表示没有
+} warehouse_entry;
+
+// 结构体：内存中的仓库模型：启动时由后台线程读入，之后靠 inotify 保持最新，菜单直接从内存显示
+//         只在 Linux 上启用；其他平台或建立监视失败时 enabled 为0，菜单照旧每次读目录
+typedef struct warehouse_model {
+    pthread_mutex_t mutex;  // 保护下面所有字段（enabled 除外，启动后不再改变）
+    pthread_cond_t loaded;  // 有仓库读完时广播，等着用这个仓库的线程醒来再看
+    int enabled;  // 模型是否可用
+    int notify_fd;  // inotify 描述符（非阻塞）
+    int data_watch;  // 对 data 目录的监视
+    int list_stale;  // data 下的仓库有增减，仓库列表需要重新读取
+    warehouse_entry* items;
+    int count;
+    int capacity;
+} warehouse_model;
+
+warehouse_model model;  // 全局变量：仓库模型
+
+int warehouse_dir_name(const char* name) {  // data 下的这个目录是不是仓库（跳过 . 和 ..，以及删除中的墓碑 .deleted.*）
+    return name[0] != '.';
+}
+
+int freezer_file_name(const char* name) {  // 是不是冰柜的数据文件（.txt、.frz 或 .journal），摘要缓存、列式快照、锁文件和临时文件的变化不用理会
+    const char* dot = strrchr(name, '.');
+    return dot && (strcmp(dot, ".txt") == 0 || strcmp(dot, ".frz") == 0 || strcmp(dot, ".journal") == 0);
+}
+
+void warehouse_model_poll() {  // 取出已经到达的文件变化通知，把对应的仓库或仓库列表标记为需要重新读取（须持有 model.mutex）
+#ifdef __linux__
+    char buffer[8192] __attribute__((aligned(__alignof__(struct inotify_event))));
+    for (;;) {
+        ssize_t len = read(model.notify_fd, buffer, sizeof(buffer));
+        if (len <= 0) break;  // 非阻塞读，没有更多通知
+        for (char* p = buffer; p < buffer + len; p += sizeof(struct inotify_event) + ((struct inotify_event*)p)->len) {
+            const struct inotify_event* ev = (const struct inotify_event*)p;
+            if (ev->mask & IN_Q_OVERFLOW) {  // 通知太多被丢掉了：全部重新读取
+                model.list_stale = 1;
+                for (int i = 0; i < model.count; i++) model.items[i].stale = 1;
+            } else if (ev->wd == model.data_watch) {
+                if (ev->mask & IN_ISDIR) model.list_stale = 1;
+            } else {
+                for (int i = 0; i < model.count; i++) {
+                    warehouse_entry* e = &model.items[i];
+                    if (e->watch != ev->wd) continue;
+                    if (ev->mask & IN_IGNORED) {  // 仓库目录被删除或改名，监视随之失效
+                        e->watch = -1;
+                        model.list_stale = 1;
+                    } else if (ev->len > 0 && freezer_file_name(ev->name)) {
+                        e->stale = 1;
+                    }
+                    break;
+                }
+            }
+        }
+    }
+#endif
+}
+
+void warehouse_model_scan() {  // 重新列出 data 下的仓库：已有的仓库保留摘要，新仓库加上监视、等待读取，消失的仓库删掉（须持有 model.mutex）
+#ifdef __linux__
+    double start = stats_start();
+    model.list_stale = 0;
+    for (int i = 0; i < model.count; i++) model.items[i].seen = 0;
+    DIR* dir = opendir("data");
+    if (dir != NULL) {
+        for (struct dirent* entry = readdir(dir); entry != NULL; entry = readdir(dir)) {
+            struct stat st;
+            char path[600];
+            if (!warehouse_dir_name(entry->d_name) || strlen(entry->d_name) >= sizeof(model.items[0].name)) continue;
+            sprintf(path, "data/%s", entry->d_name);
+            if (stat_file(path, &st) != 0 || !S_ISDIR(st.st_mode)) continue;
+            int i = 0;
+            for (; i < model.count && strcmp(model.items[i].name, entry->d_name) != 0; i++);
+            if (i == model.count) {  // 新出现的仓库
+                if (model.count == model.capacity) {
+                    int new_capacity = model.capacity ? model.capacity * 2 : 16;
+                    warehouse_entry* temp = (warehouse_entry*)realloc(model.items, (size_t)new_capacity * sizeof(warehouse_entry));
+                    if (temp == NULL) break;
+                    model.items = temp;
+                    model.capacity = new_capacity;
+                }
+                warehouse_entry* e = &model.items[model.count++];
+                strcpy(e->name, entry->d_name);
+                e->watch = inotify_add_watch(model.notify_fd, path, IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_CLOSE_WRITE | IN_MODIFY | IN_ONLYDIR);
+                e->stale = 1;
+                e->loading = 0;
+                e->summaries.items = NULL;
+                e->summaries.count = e->summaries.capacity = 0;
+                e->notes = NULL;
+            }
+            model.items[i].seen = 1;
+        }
+        closedir(dir);
+    }
+    int kept = 0;
+    for (int i = 0; i < model.count; i++) {
+        if (model.items[i].seen) {
+            model.items[kept++] = model.items[i];
+        } else {
+            if (model.items[i].watch != -1) inotify_rm_watch(model.notify_fd, model.items[i].watch);
+            free(model.items[i].summaries.items);
+            free(model.items[i].notes);
+        }
+    }
+    model.count = kept;
+    stats_stop(STATS_TIMER_SCAN, start);
+#endif
+}
+
+warehouse_entry* warehouse_entry_find(const char* name) {  // 按目录名找内存中的仓库，没有返回NULL（须持有 model.mutex）
+    for (int i = 0; i < model.count; i++) {
+        if (strcmp(model.items[i].name, name) == 0) return &model.items[i];
+    }
+    return NULL;
+}
+
+/*
+ * 函数：warehouse_entry_refresh
+ * 功能：重新读取一个仓库的冰柜摘要；读文件时放开 model.mutex，读完再加锁换进去，菜单和另一个线程不用等
+ *       读的期间 loading 为1，别的线程不会拿到读了一半的摘要，也不会同时再读；读的过程中再有变化，之后收到通知会再读一次
+ *       本线程攒下的警告也记到仓库上
+ * 参数：e - 要读取的仓库（须持有 model.mutex，且没有别的线程正在读；放开锁期间仓库数组可能变动，返回后不能再用 e）
+ * 返回：重新加锁后仍在的这个仓库，已经消失时返回NULL
+ */
+warehouse_entry* warehouse_entry_refresh(warehouse_entry* e) {
+    char name[256], path[600];
+    strcpy(name, e->name);
+    sprintf(path, "data/%s", name);
+    e->stale = 0;
+    e->loading = 1;
+    pthread_mutex_unlock(&model.mutex);
+
+    summary_cache fresh;
+    load_warehouse_summaries(path, &fresh);  // 仓库打不开时得到空的摘要
+    char* notes = NULL;
+    if (load_notes_used > 0) {
+        notes = (char*)malloc(load_notes_used + 1);
+        if (notes != NULL) memcpy(notes, load_notes, load_notes_used + 1);
+        load_notes_used = 0;
+        load_notes[0] = '\0';
+    }
+
+    pthread_mutex_lock(&model.mutex);
+    pthread_cond_broadcast(&model.loaded);
+    e = warehouse_entry_find(name);
+    if (e == NULL) {
+        free(fresh.items);
+        free(notes);
+        return NULL;
+    }
+    e->loading = 0;
+    free(e->summaries.items);
+    e->summaries = fresh;
+    if (notes != NULL && e->notes != NULL) {  // 上次的警告还没显示：接在后面
+        size_t old_len = strlen(e->notes), add_len = strlen(notes);
+        char* joined = (char*)realloc(e->notes, old_len + add_len + 1);
+        if (joined != NULL) {
+            memcpy(joined + old_len, notes, add_len + 1);
+            e->notes = joined;
+        }
+        free(notes);
+    } else if (notes != NULL) {
+        e->notes = notes;
+    }
+    return e;
+}
+
+/*
+ * 函数：warehouse_model_summaries
+ * 功能：取一个仓库的冰柜摘要：模型可用时从内存复制（别的线程正在读时等它读完，变过或还没读过的仓库先自己读），否则直接读目录
+ * 参数：warehouse_path - 仓库路径（data/warehouse_N）
+ * 参数：out - 输出的摘要，按文件名排好序（用完由调用者释放 out->items）
+ * 返回：仓库存在返回1，否则返回0
+ */
+int warehouse_model_summaries(const char* warehouse_path, summary_cache* out) {
+    const char* name = strrchr(warehouse_path, '/');
+    if (!model.enabled || name == NULL || strncmp(warehouse_path, "data/", 5) != 0) return load_warehouse_summaries(warehouse_path, out);
+    name++;
+    pthread_mutex_lock(&model.mutex);
+    warehouse_model_poll();
+    if (model.list_stale) warehouse_model_scan();
+    warehouse_entry* e = warehouse_entry_find(name);
+    int refreshed = 0;  // 自己读过一次就用读到的结果，读的过程中又有变化留给后台线程
+    for (; e != NULL && (e->loading || (e->stale && !refreshed)); ) {  // 不能拿读了一半（启动时还是空的）的摘要
+        if (e->loading) {
+            pthread_cond_wait(&model.loaded, &model.mutex);
+            e = warehouse_entry_find(name);  // 等待期间仓库数组可能变动
+        } else {
+            e = warehouse_entry_refresh(e);
+            refreshed = 1;
+        }
+    }
+    if (e == NULL) {
+        pthread_mutex_unlock(&model.mutex);
+        return load_warehouse_summaries(warehouse_path, out);
+    }
+    if (e->notes != NULL) {  // 后台读取时遇到的问题在这里告诉用户
+        fputs(e->notes, stdout);
+        free(e->notes);
+        e->notes = NULL;
+    }
+    out->count = out->capacity = e->summaries.count;
+    out->items = (freezer_summary*)malloc((size_t)(out->count ? out->count : 1) * sizeof(freezer_summary));
+    if (out->items == NULL) out->count = out->capacity = 0;
+    else memcpy(out->items, e->summaries.items, (size_t)out->count * sizeof(freezer_summary));
+    pthread_mutex_unlock(&model.mutex);
+    return 1;
+}
+
+void* warehouse_loader_main(void* arg) {  // 后台线程：启动时把所有仓库的摘要读进内存，之后等文件变化通知，变了就提前重新读取
+    (void)arg;
+#ifdef __linux__
+    load_quiet = 1;  // 读取时的警告不直接打印，以免打断菜单，攒下来由主线程显示
+    for (;;) {
+        pthread_mutex_lock(&model.mutex);
+        warehouse_model_poll();
+        if (model.list_stale) warehouse_model_scan();
+        int refreshed = 0;
+        for (int i = 0; i < model.count && !refreshed; i++) {
+            if (model.items[i].stale && !model.items[i].loading) {  // 主线程正在读的仓库不重复读，读完仍是 stale 时下一轮再读
+                warehouse_entry_refresh(&model.items[i]);  // 每次只读一个仓库，读文件时不持有锁
+                refreshed = 1;
+            }
+        }
+        pthread_mutex_unlock(&model.mutex);
+        if (!refreshed) {
+            struct pollfd p = {model.notify_fd, POLLIN, 0};
+            poll(&p, 1, -1);  // 等下一批通知
+        }
+    }
+#endif
+    return NULL;
+}
+
+void warehouse_model_start() {  // 建立对 data 目录的监视，并启动后台读取线程；失败时模型不启用
+#ifdef __linux__
+    model.notify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (model.notify_fd == -1) return;
+    model.data_watch = inotify_add_watch(model.notify_fd, "data", IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR);
+    if (model.data_watch == -1) {
+        close(model.notify_fd);
+        return;
+    }
+    pthread_mutex_init(&model.mutex, NULL);
+    pthread_cond_init(&model.loaded, NULL);
+    model.list_stale = 1;
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, warehouse_loader_main, NULL) == 0) {
+        pthread_detach(thread);
+        model.enabled = 1;
+    }
+#endif
+}
+
+void show_maininterface() {  // 显示一级菜单
+    printf("\n=== Main Menu ===\n");
+    printf("Welcome to llwwds' freezer management system\n");
+    printf("\n");
+
+    warehouse_number = 0;  // 重置仓库计数
+    int max_num = 0; // 用局部变量替代全局计数器
+    if (model.enabled) {  // 仓库模型已建立：直接从内存列出，不再读目录
+        pthread_mutex_lock(&model.mutex);
+        warehouse_model_poll();
+        if (model.list_stale) warehouse_model_scan();
+        for (int i = 0; i < model.count; i++) {
+            int num;
+            if (sscanf(model.items[i].name, "warehouse_%d", &num) == 1 && num > max_num) max_num = num;
+            printf("  [Warehouse] %s\n", model.items[i].name);
+        }
+        pthread_mutex_unlock(&model.mutex);
+        warehouse_number = max_num;
+    } else {
+        double start = stats_start();
+        DIR *dir = opendir("data"); // 打开data目录，DIR为读取文件用的数据类型，若失败则返回NULL
+        if (dir!=NULL) {
+            for (struct dirent *temp = readdir(dir); temp != NULL; temp = readdir(dir)) {
+                struct stat st;  // 文件状态结构体
+                char path[600];  // 路径缓冲区
+                sprintf(path, "data/%s", temp->d_name);
+            
+                if (warehouse_dir_name(temp->d_name) && stat_file(path, &st) == 0 && S_ISDIR(st.st_mode)) {
+                    // 检查当前查看的文件是否 为仓库（不为当前文件、上一级文件、删除中的墓碑），且为文件夹 若满足条件则读它的编号
+                    int num;
+                    if (sscanf(temp->d_name, "warehouse_%d", &num) == 1 && num > max_num) {
+                        max_num = num;
+                    }
+                    printf("  [Warehouse] %s\n", temp->d_name); // 打印仓库名
+                }
+            }
+            closedir(dir); // 关闭目录
+            warehouse_number = max_num; // 仅更新一次
+            stats_stop(STATS_TIMER_SCAN, start);
+        }
+        else{
+            printf("Error: Cannot open data directory\n");  // 若失败，则报错并返回
+            return;
+        }
+    }
+
+    printf("\n");  // 显示文件名之后，打印操作提示
+    printf("========== Main Menu ==========\n");
+    printf(" [0] Create Warehouse\n");
+    printf(" [1] Open Warehouse\n");
+    printf(" [2] Delete Warehouse\n");
+    printf(" [3] Search All Warehouses\n");
+    printf(" [4] Show Stats\n");
+    printf(" [-1] Exit\n");
+    printf("===============================\n");
+    printf("Please enter a number to operate: ");
+}
+
+void show_inside_warehoues(char* target_warehouse_path) {  // 显示二级菜单（仓库内的冰柜们），列出指定仓库内的所有冰柜 传入：仓库路径 冰柜的状态来自摘要缓存，只有改动过的冰柜才重新读取
+    printf("\n=== Warehouse: %s ===\n", target_warehouse_path);
+    struct stat temp;  // 存放文件夹的属性信息
+    if (stat_file(target_warehouse_path, &temp) != 0 || !S_ISDIR(temp.st_mode)) {  // 若无法打开，则报错并返回
+        printf("The warehouse does not exist.\n");
+        return;
+    }
+
+    summary_cache summaries;
+    if (!warehouse_model_summaries(target_warehouse_path, &summaries)) {
+        printf("Error: Cannot open warehouse directory\n");  // 若失败，则报错并返回
+        return;
+    }
+    for (int i = 0; i < summaries.count; i++) {
+        const freezer_summary* e = &summaries.items[i];
+        printf("  [Freezer] %s  Temperature: %d C  Available: %d / %d\n", e->file_name, e->temperature, e->available_volume, FREZZER_CAPACITY);
+    }
+    if (summaries.count == 0) printf("  (Empty)\n"); // 如果没有冰柜，提示为空
+    free(summaries.items);
+
+    // 显示操作选项
+    printf("\n");
+    printf("Enter 0 to create a new freezer\n");
+    printf("Enter 1 to open a freezer\n");
+    printf("Enter 2 to delete a freezer\n");
+    printf("Enter 3 to place food in any freezer with room\n");
+    printf("Enter 4 to show the warehouse report\n");
+    printf("Enter -1 to return\n");
+    printf("Please enter a number to operate: ");
+}
+
+int cpu_count() {  // 可用的CPU核数，取不到时按4个算；设置了 worker_threads 时用它
+    if (worker_threads > 0) return worker_threads;
+#ifdef _WIN32
+    return 4;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 4;
+#endif
+}
+
+// 结构体：一批并行任务，线程们从 next 依次领取任务编号
+typedef struct parallel_job {
+    void (*task)(void* ctx, int task_index, int thread_index);  // 任务函数
+    void* ctx;  // 传给任务函数的上下文
+    int task_count;  // 任务总数
+    atomic_int next;  // 下一个待领取的任务编号
+} parallel_job;
+
+// 结构体：一个工作线程的参数
+typedef struct parallel_worker {
+    parallel_job* job;
+    int thread_index;  // 线程编号，0..线程数-1，任务可用它找到自己的结果缓冲区
+    pthread_t thread;
+} parallel_worker;
+
+void* parallel_worker_main(void* arg) {  // 工作线程：不断领取任务直到领完
+    parallel_worker* w = (parallel_worker*)arg;
+    for (int i = atomic_fetch_add(&w->job->next, 1); i < w->job->task_count; i = atomic_fetch_add(&w->job->next, 1)) {
+        w->job->task(w->job->ctx, i, w->thread_index);
+    }
+    return NULL;
+}
+
+/*
+ * 函数：run_parallel
+ * 功能：用thread_count个线程（含当前线程）执行task_count个任务，全部完成后返回
+ * 参数：task_count - 任务数量
+ * 参数：thread_count - 线程数量，线程创建失败时由剩下的线程完成全部任务
+ * 参数：task - 任务函数，参数为上下文、任务编号、线程编号
+ * 参数：ctx - 传给任务函数的上下文
+ */
+void run_parallel(int task_count, int thread_count, void (*task)(void*, int, int), void* ctx) {
+    parallel_job job;
+    job.task = task;
+    job.ctx = ctx;
+    job.task_count = task_count;
+    atomic_init(&job.next, 0);
+
+    parallel_worker* workers = (parallel_worker*)malloc((size_t)thread_count * sizeof(parallel_worker));
+    int started = 1;  // 0号由当前线程担任
+    if (workers != NULL) {
+        for (int i = 1; i < thread_count; i++) {
+            workers[started].job = &job;
+            workers[started].thread_index = started;
+            if (pthread_create(&workers[started].thread, NULL, parallel_worker_main, &workers[started]) == 0) started++;
+        }
+    }
+    parallel_worker self;
+    self.job = &job;
+    self.thread_index = 0;
+    parallel_worker_main(&self);
+    for (int i = 1; i < started; i++) pthread_join(workers[i].thread, NULL);
+    free(workers);
+}
+
+// 结构体：冰柜文件列表（存冰柜的文本文件路径，实际读取哪个文件由load_freezer_from_file决定）
+typedef struct freezer_file_list {
+    char (*paths)[600];
+    int count;
+    int capacity;
+} freezer_file_list;
+
+int freezer_file_list_add(freezer_file_list* l, const char* text_path) {  // 追加一个冰柜路径，成功返回1
+    if (l->count == l->capacity) {
+        int new_capacity = l->capacity ? l->capacity * 2 : 64;
+        char (*temp)[600] = realloc(l->paths, (size_t)new_capacity * sizeof(*l->paths));
+        if (temp == NULL) return 0;
+        l->paths = temp;
+        l->capacity = new_capacity;
+    }
+    strcpy(l->paths[l->count++], text_path);
+    return 1;
+}
+
+void collect_warehouse_freezers(const char* warehouse_path, freezer_file_list* l) {  // 把一个仓库中的冰柜加入列表，规则与仓库列表一致
+    DIR* dir = opendir(warehouse_path);
+    if (dir == NULL) return;
+    double start = stats_start();
+    for (struct dirent* entry = readdir(dir); entry != NULL; entry = readdir(dir)) {
+        struct stat temp;
+        char path[600];
+        int len = snprintf(path, sizeof(path), "%s/%s", warehouse_path, entry->d_name);
+        if (len < 0 || (size_t)len >= sizeof(path)) continue;  // 路径太长，放不下
+        char* dot = strrchr(path, '.');
+        if (!dot || (strcmp(dot, ".txt") != 0 && strcmp(dot, ".frz") != 0)) continue;
+        if (stat_file(path, &temp) != 0 || !S_ISREG(temp.st_mode)) continue;
+
+        int is_binary = strcmp(dot, ".frz") == 0;
+        char binary_path[610];
+        strcpy(dot, ".txt");
+        if (freezer_uses_binary(path, binary_path) != is_binary) continue;  // 同一个冰柜只算一次
+        freezer_file_list_add(l, path);
+    }
+    closedir(dir);
+    stats_stop(STATS_TIMER_SCAN, start);
+}
+
+void collect_all_freezers(freezer_file_list* l) {  // 把data下所有仓库中的冰柜加入列表
+    DIR* dir = opendir("data");
+    if (dir == NULL) return;
+    for (struct dirent* entry = readdir(dir); entry != NULL; entry = readdir(dir)) {
+        struct stat temp;
+        char path[600];
+        if (!warehouse_dir_name(entry->d_name) || strlen(entry->d_name) > 500) continue;
+        sprintf(path, "data/%s", entry->d_name);
+        if (stat_file(path, &temp) == 0 && S_ISDIR(temp.st_mode)) collect_warehouse_freezers(path, l);
+    }
+    closedir(dir);
+}
+
+// 结构体：全局查询的筛选条件
+typedef struct food_query {
+    char type[100];  // 食物种类，空字符串表示不限
+    char name_prefix[100];  // 名称前缀，空字符串表示不限
+    int volume_min, volume_max;  // 体积范围（含两端）
+    int temperature_min, temperature_max;  // 温度范围（含两端）
+} food_query;
+
+// 结构体：一条查询结果
+typedef struct query_match {
+    int file;  // 所在冰柜在文件列表中的下标
+    food item;
+} query_match;
+
+// 结构体：一个线程的查询结果缓冲区，线程之间互不干扰，最后再合并
+typedef struct match_buffer {
+    query_match* items;
+    int count;
+    int capacity;
+} match_buffer;
+
+// 结构体：一次全局查询的上下文
+typedef struct query_context {
+    const food_query* query;
+    const freezer_file_list* files;
+    match_buffer* buffers;  // 每个线程一个缓冲区
+    frezzer* freezers;  // 每个线程一个冰柜，读下一个文件时复用上一个的内存
+    int* file_thread;  // 每个冰柜的结果在哪个线程的缓冲区里
+    int* file_start;  // 以及从第几条开始
+    int* file_matches;  // 共几条
+} query_context;
+
+int food_matches(const food_query* q, const food_store* s, const food_record* r) {  // 判断一个食物是否满足种类以外的筛选条件（种类由种类索引保证），先比较数值再比较名称
+    return r->volume >= q->volume_min && r->volume <= q->volume_max
+        && r->temperature >= q->temperature_min && r->temperature <= q->temperature_max
+        && strncmp(food_record_name(s, r), q->name_prefix, strlen(q->name_prefix)) == 0;
+}
+
+void match_buffer_add(match_buffer* b, int file, const food_store* s, int slot) {  // 追加一条结果（还原成food），内存不足时丢弃
+    if (b->count == b->capacity) {
+        int new_capacity = b->capacity ? b->capacity * 2 : 64;
+        query_match* temp = (query_match*)realloc(b->items, (size_t)new_capacity * sizeof(query_match));
+        if (temp == NULL) return;
+        b->items = temp;
+        b->capacity = new_capacity;
+    }
+    b->items[b->count].file = file;
+    food_store_get(s, slot, &b->items[b->count].item);
+    b->count++;
+}
+
+void query_freezer_task(void* arg, int file, int thread) {  // 并行任务：读取一个冰柜并把匹配的食物放进本线程的缓冲区
+    query_context* ctx = (query_context*)arg;
+    match_buffer* b = &ctx->buffers[thread];
+    frezzer* f = &ctx->freezers[thread];
+    load_freezer_from_file(ctx->files->paths[file], f);
+
+    ctx->file_thread[file] = thread;
+    ctx->file_start[file] = b->count;
+    if (ctx->query->type[0] != '\0') {  // 指定了种类时走种类索引，只看这一种；编号要在读完文件后再查，种类可能是这个文件新加进字典的
+        uint16_t type_id = food_type_find(ctx->query->type);
+        for (int i = food_store_find(&f->store, -1, type_id); i != -1; i = food_store_find(&f->store, i, type_id)) {
+            if (food_matches(ctx->query, &f->store, &f->store.items[i])) match_buffer_add(b, file, &f->store, i);
+        }
+    } else {
+        for (int i = f->store.first; i != -1; i = f->store.links[i].next) {
+            if (food_matches(ctx->query, &f->store, &f->store.items[i])) match_buffer_add(b, file, &f->store, i);
+        }
+    }
+    ctx->file_matches[file] = b->count - ctx->file_start[file];
+}
+
+/*
+ * 函数：query_all_warehouses
+ * 功能：用线程池在所有仓库的所有冰柜中查找满足条件的食物，每个冰柜文件一个任务，结果按冰柜顺序输出
+ * 参数：q - 筛选条件
+ */
+void query_all_warehouses(const food_query* q) {
+    double start = now_ms();
+    double stats = stats_start();
+    freezer_file_list files = {NULL, 0, 0};
+    collect_all_freezers(&files);
+
+    int threads = cpu_count();
+    if (threads > files.count) threads = files.count;
+    if (threads < 1) threads = 1;
+
+    query_context ctx;
+    ctx.query = q;
+    ctx.files = &files;
+    ctx.buffers = (match_buffer*)calloc((size_t)threads, sizeof(match_buffer));
+    ctx.freezers = (frezzer*)malloc((size_t)threads * sizeof(frezzer));
+    for (int i = 0; ctx.freezers != NULL && i < threads; i++) frezzer_init(&ctx.freezers[i]);
+    ctx.file_thread = (int*)calloc((size_t)files.count + 1, sizeof(int));
+    ctx.file_start = (int*)calloc((size_t)files.count + 1, sizeof(int));
+    ctx.file_matches = (int*)calloc((size_t)files.count + 1, sizeof(int));
+    if (ctx.buffers == NULL || ctx.freezers == NULL || ctx.file_thread == NULL || ctx.file_start == NULL || ctx.file_matches == NULL) {
+        printf("Error: Out of memory\n");
+    } else {
+        run_parallel(files.count, threads, query_freezer_task, &ctx);
+        double elapsed = now_ms() - start;
+
+        int total = 0;  // 合并：按冰柜顺序依次取出各线程缓冲区中的结果
+        printf("\n%-28s %-17s %-10s %-10s %-10s\n", "Freezer", "Name", "Type", "Volume", "Temp");
+        for (int file = 0; file < files.count; file++) {
+            const match_buffer* b = &ctx.buffers[ctx.file_thread[file]];
+            char* name = files.paths[file] + (strncmp(files.paths[file], "data/", 5) == 0 ? 5 : 0);
+            char* dot = strrchr(name, '.');
+            if (dot) *dot = '\0';  // 只显示 仓库/冰柜
+            for (int i = ctx.file_start[file]; i < ctx.file_start[file] + ctx.file_matches[file]; i++) {
+                const food* item = &b->items[i].item;
+                printf("%-28s %-17s %-10s %-10d %-10d\n", name, item->food_name, item->food_type, item->food_volume, item->food_temperature);
+                total++;
+            }
+        }
+        if (total == 0) printf("  None found.\n");
+        printf("\n%d match(es) in %d freezer file(s), %d thread(s), %.2f ms\n", total, files.count, threads, elapsed);
+    }
+
+    for (int i = 0; ctx.buffers != NULL && i < threads; i++) free(ctx.buffers[i].items);
+    for (int i = 0; ctx.freezers != NULL && i < threads; i++) frezzer_free(&ctx.freezers[i]);
+    free(ctx.buffers);
+    free(ctx.freezers);
+    free(ctx.file_thread);
+    free(ctx.file_start);
+    free(ctx.file_matches);
+    free(files.paths);
+    stats_stop(STATS_TIMER_QUERY, stats);
+}
+
+#define SNAPSHOT_BAND_WIDTH 5  // 报表中温度分段的宽度（度）
+#define SNAPSHOT_BANDS ((FREZZER_TEMP_RANGE + SNAPSHOT_BAND_WIDTH - 1) / SNAPSHOT_BAND_WIDTH)  // 温度分段数
+
+// 结构体：列式快照中的一个冰柜：摘要（与摘要缓存一样按修改时间和大小判断是否要重新读取）和它的食物在各列中的范围
+typedef struct snapshot_freezer {
+    freezer_summary summary;
+    int32_t first;  // 第一个食物在各列中的下标
+    int32_t count;  // 食物数量
+} snapshot_freezer;
+
+// 结构体：仓库的列式快照（仓库目录下的 warehouse.col）：各冰柜的食物按显示顺序依次排在每一列中，统计时只扫需要的列
+typedef struct warehouse_snapshot {
+    snapshot_freezer* freezers;  // 按文件名排好序
+    int freezer_count;
+    int freezer_capacity;
+    int32_t* volume;  // 体积列
+    uint32_t* name_offset;  // 名称列：名称在names中的偏移
+    int16_t* temperature;  // 温度列
+    uint16_t* type_id;  // 种类列（种类字典中的编号）
+    int item_count;
+    int item_capacity;
+    char* names;  // 名称区：所有名称依次存放，各以'\0'结尾
+    size_t names_used;
+    size_t names_capacity;
+} warehouse_snapshot;
+
+// 结构体：快照文件的文件头，后面依次是冰柜表、种类名称表、体积列、名称偏移列、温度列、种类列、名称区
+typedef struct snapshot_file_header {
+    char magic[4];  // 固定为 "FRZC"
+    uint32_t version;  // 格式版本，目前是1
+    int32_t capacity, temp_min, temp_max;  // 写快照时的容量和温度范围，冰柜摘要依赖它们，与当前编译的不同时快照作废
+    uint32_t freezer_count;
+    uint32_t item_count;
+    uint32_t type_count;  // 种类名称表中的种类数，文件中种类列的编号是这张表的下标
+    uint32_t type_bytes;  // 种类名称表的字节数（各以'\0'结尾）
+    uint32_t names_bytes;  // 名称区的字节数
+} snapshot_file_header;
+
+void snapshot_free(warehouse_snapshot* s) {  // 释放快照的内存，之后是空快照
+    free(s->freezers);
+    free(s->volume);
+    free(s->name_offset);
+    free(s->temperature);
+    free(s->type_id);
+    free(s->names);
+    memset(s, 0, sizeof(*s));
+}
+
+int snapshot_reserve(warehouse_snapshot* s, int freezers, int items, size_t names) {  // 保证还能再放下这么多冰柜、食物和名称字节，成功返回1
+    if (s->freezer_count + freezers > s->freezer_capacity) {
+        int new_capacity = s->freezer_capacity ? s->freezer_capacity * 2 : 16;
+        if (new_capacity < s->freezer_count + freezers) new_capacity = s->freezer_count + freezers;
+        snapshot_freezer* temp = (snapshot_freezer*)realloc(s->freezers, (size_t)new_capacity * sizeof(snapshot_freezer));
+        if (temp == NULL) return 0;
+        s->freezers = temp;
+        s->freezer_capacity = new_capacity;
+    }
+    if (s->item_count + items > s->item_capacity) {  // 四列一起扩容
+        int new_capacity = s->item_capacity ? s->item_capacity * 2 : 1024;
+        if (new_capacity < s->item_count + items) new_capacity = s->item_count + items;
+        int32_t* volume = (int32_t*)realloc(s->volume, (size_t)new_capacity * sizeof(int32_t));
+        if (volume != NULL) s->volume = volume;
+        uint32_t* name_offset = (uint32_t*)realloc(s->name_offset, (size_t)new_capacity * sizeof(uint32_t));
+        if (name_offset != NULL) s->name_offset = name_offset;
+        int16_t* temperature = (int16_t*)realloc(s->temperature, (size_t)new_capacity * sizeof(int16_t));
+        if (temperature != NULL) s->temperature = temperature;
+        uint16_t* type_id = (uint16_t*)realloc(s->type_id, (size_t)new_capacity * sizeof(uint16_t));
+        if (type_id != NULL) s->type_id = type_id;
+        if (volume == NULL || name_offset == NULL || temperature == NULL || type_id == NULL) return 0;
+        s->item_capacity = new_capacity;
+    }
+    if (s->names_used + names > s->names_capacity) {
+        size_t new_capacity = s->names_capacity ? s->names_capacity * 2 : 16384;
+        if (new_capacity < s->names_used + names) new_capacity = s->names_used + names;
+        if (new_capacity > 0xFFFFFFFFu) return 0;  // 名称偏移是32位的
+        char* temp = (char*)realloc(s->names, new_capacity);
+        if (temp == NULL) return 0;
+        s->names = temp;
+        s->names_capacity = new_capacity;
+    }
+    return 1;
+}
+
+/*
+ * 函数：snapshot_add_freezer
+ * 功能：把一个读好的冰柜追加到快照末尾，食物按显示顺序拆进各列
+ * 参数：s - 快照
+ * 参数：summary - 冰柜的摘要（文件名、修改时间、大小），温度和可用容积取自冰柜
+ * 参数：f - 冰柜
+ * 返回：成功返回1，内存不足返回0
+ */
+int snapshot_add_freezer(warehouse_snapshot* s, const freezer_summary* summary, const frezzer* f) {
+    const food_store* store = &f->store;
+    size_t names = 0;
+    for (int i = store->first; i != -1; i = store->links[i].next) names += strlen(food_record_name(store, &store->items[i])) + 1;
+    if (!snapshot_reserve(s, 1, store->count, names)) return 0;
+
+    snapshot_freezer* e = &s->freezers[s->freezer_count++];
+    e->summary = *summary;
+    e->summary.temperature = f->frezzer_temperature;
+    e->summary.available_volume = f->frezzer_available_volume;
+    e->first = s->item_count;
+    e->count = store->count;
+    for (int i = store->first; i != -1; i = store->links[i].next) {
+        const food_record* r = &store->items[i];
+        const char* name = food_record_name(store, r);
+        size_t len = strlen(name) + 1;
+        s->volume[s->item_count] = r->volume;
+        s->name_offset[s->item_count] = (uint32_t)s->names_used;
+        s->temperature[s->item_count] = r->temperature;
+        s->type_id[s->item_count] = r->type_id;
+        s->item_count++;
+        memcpy(s->names + s->names_used, name, len);
+        s->names_used += len;
+    }
+    return 1;
+}
+
+int snapshot_copy_freezer(warehouse_snapshot* s, const warehouse_snapshot* from, int index) {  // 把另一个快照中的第index个冰柜原样追加到快照末尾，成功返回1
+    const snapshot_freezer* src = &from->freezers[index];
+    size_t names_begin = src->count > 0 ? from->name_offset[src->first] : 0;  // 一个冰柜的名称在名称区中是连续的
+    size_t names_end = src->first + src->count < from->item_count ? from->name_offset[src->first + src->count] : from->names_used;
+    if (src->count == 0) names_end = names_begin;
+    if (!snapshot_reserve(s, 1, src->count, names_end - names_begin)) return 0;
+
+    snapshot_freezer* e = &s->freezers[s->freezer_count++];
+    *e = *src;
+    e->first = s->item_count;
+    memcpy(s->volume + s->item_count, from->volume + src->first, (size_t)src->count * sizeof(int32_t));
+    memcpy(s->temperature + s->item_count, from->temperature + src->first, (size_t)src->count * sizeof(int16_t));
+    memcpy(s->type_id + s->item_count, from->type_id + src->first, (size_t)src->count * sizeof(uint16_t));
+    uint32_t shift = (uint32_t)(s->names_used - names_begin);  // 名称偏移整体平移（无符号回绕也正确）
+    for (int i = 0; i < src->count; i++) s->name_offset[s->item_count + i] = from->name_offset[src->first + i] + shift;
+    memcpy(s->names + s->names_used, from->names + names_begin, names_end - names_begin);
+    s->item_count += src->count;
+    s->names_used += names_end - names_begin;
+    return 1;
+}
+
+int snapshot_read(FILE* fp, void* out, size_t bytes) {  // 读取快照文件的一段，读满返回1
+    size_t got = bytes > 0 ? fread(out, 1, bytes, fp) : 0;
+    stats_count(STATS_BYTES_READ, (long long)got);
+    return got == bytes;
+}
+
+/*
+ * 函数：snapshot_load
+ * 功能：读取仓库的快照文件，并把文件中的种类编号换成本进程种类字典的编号
+ * 参数：warehouse_path - 仓库路径
+ * 参数：s - 输出的快照（须为空快照）；文件不存在、损坏或容量和温度范围与当前编译的不同时得到空快照
+ * 返回：读到了可用的快照返回1，否则返回0
+ */
+int snapshot_load(const char* warehouse_path, warehouse_snapshot* s) {
+    char path[620];
+    sprintf(path, "%s/warehouse.col", warehouse_path);
+    FILE* fp = fopen(path, "rb");
+    if (fp == NULL) return 0;
+
+    snapshot_file_header h;
+    char* types = NULL;
+    int ok = snapshot_read(fp, &h, sizeof(h)) && memcmp(h.magic, "FRZC", 4) == 0 && h.version == 1
+        && h.capacity == FREZZER_CAPACITY && h.temp_min == FREZZER_TEMP_MIN && h.temp_max == FREZZER_TEMP_MAX
+        && h.freezer_count <= 0x7FFFFFFFu && h.item_count <= 0x7FFFFFFFu && h.type_count <= FOOD_TYPE_NONE
+        && snapshot_reserve(s, (int)h.freezer_count, (int)h.item_count, h.names_bytes)
+        && (types = (char*)malloc((size_t)h.type_bytes + 1)) != NULL
+        && snapshot_read(fp, s->freezers, (size_t)h.freezer_count * sizeof(snapshot_freezer))
+        && snapshot_read(fp, types, h.type_bytes)
+        && snapshot_read(fp, s->volume, (size_t)h.item_count * sizeof(int32_t))
+        && snapshot_read(fp, s->name_offset, (size_t)h.item_count * sizeof(uint32_t))
+        && snapshot_read(fp, s->temperature, (size_t)h.item_count * sizeof(int16_t))
+        && snapshot_read(fp, s->type_id, (size_t)h.item_count * sizeof(uint16_t))
+        && snapshot_read(fp, s->names, h.names_bytes)
+        && fgetc(fp) == EOF;
+    fclose(fp);
+    s->freezer_count = ok ? (int)h.freezer_count : 0;
+    s->item_count = ok ? (int)h.item_count : 0;
+    s->names_used = ok ? h.names_bytes : 0;
+
+    int next = 0;  // 校验：各冰柜的食物首尾相接，名称偏移在名称区内，名称区以'\0'结尾
+    for (int i = 0; ok && i < s->freezer_count; i++) {
+        const snapshot_freezer* e = &s->freezers[i];
+        ok = e->first == next && e->count >= 0 && e->count <= s->item_count - next
+            && memchr(e->summary.file_name, '\0', sizeof(e->summary.file_name)) != NULL;
+        next += ok ? e->count : 0;
+    }
+    ok = ok && next == s->item_count && (s->names_used == 0 ? s->item_count == 0 : s->names[s->names_used - 1] == '\0');
+    for (int i = 0; ok && i < s->item_count; i++) ok = s->name_offset[i] < s->names_used && (i == 0 ? s->name_offset[i] == 0 : s->name_offset[i] > s->name_offset[i - 1]);
+
+    uint16_t* remap = ok ? (uint16_t*)malloc(((size_t)h.type_count + 1) * sizeof(uint16_t)) : NULL;  // 文件中的编号 -> 种类字典中的编号
+    if (remap != NULL) {
+        types[h.type_bytes] = '\0';
+        const char* p = types;
+        for (uint32_t i = 0; i < h.type_count; i++) {
+            remap[i] = p < types + h.type_bytes ? food_type_intern(p) : FOOD_TYPE_NONE;
+            p += strlen(p) + 1;
+        }
+        for (int i = 0; i < s->item_count; i++) s->type_id[i] = s->type_id[i] < h.type_count ? remap[s->type_id[i]] : FOOD_TYPE_NONE;
+        free(remap);
+    }
+    free(types);
+    if (remap == NULL) snapshot_free(s);
+    return remap != NULL;
+}
+
+void snapshot_save(const char* warehouse_path, const warehouse_snapshot* s) {  // 写回快照文件（先写唯一的临时文件再改名）
+    char path[620], temp_path[630];
+    sprintf(path, "%s/warehouse.col", warehouse_path);
+    FILE* fp = open_unique_temp(path, temp_path, "wb");
+    if (fp == NULL) return;
+
+    snapshot_file_header h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, "FRZC", 4);
+    h.version = 1;
+    h.capacity = FREZZER_CAPACITY;
+    h.temp_min = FREZZER_TEMP_MIN;
+    h.temp_max = FREZZER_TEMP_MAX;
+    h.freezer_count = (uint32_t)s->freezer_count;
+    h.item_count = (uint32_t)s->item_count;
+    h.type_count = (uint32_t)atomic_load(&food_types.count);  // 种类列直接存字典编号，名称表就是整个字典
+    for (uint32_t i = 0; i < h.type_count; i++) h.type_bytes += (uint32_t)strlen(food_type_name((uint16_t)i)) + 1;
+    h.names_bytes = (uint32_t)s->names_used;
+
+    fwrite(&h, sizeof(h), 1, fp);
+    fwrite(s->freezers, sizeof(snapshot_freezer), (size_t)s->freezer_count, fp);
+    for (uint32_t i = 0; i < h.type_count; i++) fwrite(food_type_name((uint16_t)i), 1, strlen(food_type_name((uint16_t)i)) + 1, fp);
+    fwrite(s->volume, sizeof(int32_t), (size_t)s->item_count, fp);
+    fwrite(s->name_offset, sizeof(uint32_t), (size_t)s->item_count, fp);
+    fwrite(s->temperature, sizeof(int16_t), (size_t)s->item_count, fp);
+    fwrite(s->type_id, sizeof(uint16_t), (size_t)s->item_count, fp);
+    fwrite(s->names, 1, s->names_used, fp);
+    stats_count(STATS_BYTES_WRITTEN, ftell(fp));
+    if (ferror(fp) | fclose(fp)) {
+        remove(temp_path);
+        return;
+    }
+#ifdef _WIN32
+    remove(path);
+#endif
+    if (rename(temp_path, path) != 0) remove(temp_path);
+}
+
+// 结构体：一次快照刷新的上下文，需要重新读取的冰柜由线程池并行读取，各自先放进一个单冰柜的小快照
+typedef struct snapshot_context {
+    const char* warehouse_path;
+    const summary_cache* files;  // 仓库中的冰柜文件
+    const int* reload;  // 需要重新读取的冰柜在 files 中的下标
+    warehouse_snapshot* parts;  // 每个重新读取的冰柜一个小快照
+    frezzer* freezers;  // 每个线程一个冰柜，读下一个文件时复用上一个的内存
+} snapshot_context;
+
+void snapshot_load_task(void* arg, int task, int thread) {  // 并行任务：读取一个冰柜（与打开冰柜相同的 load_freezer_from_file），拆成列
+    snapshot_context* ctx = (snapshot_context*)arg;
+    const freezer_summary* e = &ctx->files->items[ctx->reload[task]];
+    char path[600], text_path[600];
+    freezer_entry_paths(ctx->warehouse_path, e->file_name, path, text_path);
+    load_freezer_from_file(text_path, &ctx->freezers[thread]);
+    snapshot_add_freezer(&ctx->parts[task], e, &ctx->freezers[thread]);
+}
+
+/*
+ * 函数：warehouse_snapshot_refresh
+ * 功能：取仓库的最新列式快照：文件没变的冰柜沿用上次的快照，改动过或新增的冰柜并行重新读取；有变化时写回快照文件
+ * 参数：warehouse_path - 仓库路径
+ * 参数：s - 输出的快照（用完由调用者 snapshot_free）
+ * 参数：reloaded - 输出重新读取的冰柜数
+ * 返回：成功返回1，仓库打不开或内存不足返回0
+ */
+int warehouse_snapshot_refresh(const char* warehouse_path, warehouse_snapshot* s, int* reloaded) {
+    memset(s, 0, sizeof(*s));
+    *reloaded = 0;
+    double start = stats_start();
+    summary_cache files;
+    if (!scan_warehouse_freezers(warehouse_path, &files)) return 0;
+    warehouse_snapshot old;
+    memset(&old, 0, sizeof(old));
+    snapshot_load(warehouse_path, &old);
+
+    // 两边都按文件名排好序，一起往下走：找到且修改时间和大小都没变的沿用旧快照（from[i]为旧快照中的下标），其余重新读取
+    int* from = (int*)malloc(((size_t)files.count + 1) * sizeof(int));
+    int* reload = (int*)malloc(((size_t)files.count + 1) * sizeof(int));
+    int ok = from != NULL && reload != NULL;
+    for (int i = 0, j = 0; ok && i < files.count; i++) {
+        const freezer_summary* e = &files.items[i];
+        for (; j < old.freezer_count && strcmp(old.freezers[j].summary.file_name, e->file_name) < 0; j++);
+        const freezer_summary* cached = j < old.freezer_count ? &old.freezers[j].summary : NULL;
+        if (cached != NULL && strcmp(cached->file_name, e->file_name) == 0 && cached->mtime == e->mtime && cached->size == e->size) {
+            from[i] = j;
+        } else {
+            from[i] = -1;
+            reload[(*reloaded)++] = i;
+        }
+    }
+
+    snapshot_context ctx;
+    ctx.warehouse_path = warehouse_path;
+    ctx.files = &files;
+    ctx.reload = reload;
+    ctx.parts = ok ? (warehouse_snapshot*)calloc((size_t)*reloaded + 1, sizeof(warehouse_snapshot)) : NULL;
+    int threads = cpu_count();
+    if (threads > *reloaded) threads = *reloaded;
+    if (threads < 1) threads = 1;
+    ctx.freezers = ok ? (frezzer*)malloc((size_t)threads * sizeof(frezzer)) : NULL;
+    ok = ctx.parts != NULL && ctx.freezers != NULL;
+    for (int i = 0; ok && i < threads; i++) frezzer_init(&ctx.freezers[i]);
+    if (ok) run_parallel(*reloaded, threads, snapshot_load_task, &ctx);
+
+    for (int i = 0, k = 0; ok && i < files.count; i++) {  // 按文件名顺序拼成新快照
+        if (from[i] != -1) {
+            ok = snapshot_copy_freezer(s, &old, from[i]);
+        } else {
+            ok = ctx.parts[k].freezer_count == 1 && snapshot_copy_freezer(s, &ctx.parts[k], 0);
+            k++;
+        }
+    }
+    if (ok && (*reloaded > 0 || s->freezer_count != old.freezer_count)) snapshot_save(warehouse_path, s);  // 有变化时才写回
+
+    for (int i = 0; ctx.parts != NULL && i < *reloaded; i++) snapshot_free(&ctx.parts[i]);
+    for (int i = 0; ctx.freezers != NULL && i < threads; i++) frezzer_free(&ctx.freezers[i]);
+    free(ctx.parts);
+    free(ctx.freezers);
+    free(from);
+    free(reload);
+    free(files.items);
+    snapshot_free(&old);
+    if (!ok) snapshot_free(s);
+    stats_stop(STATS_TIMER_SCAN, start);
+    return ok;
+}
+
+/*
+ * 函数：group_volume_by_type
+ * 功能：聚合内核：按种类分组累计食物数和总体积，只读种类列和体积列
+ * 参数：type_id、volume - 两列，各n项
+ * 参数：items、volume_sum - 输出，以种类编号为下标（须有65536项且已清零）
+ */
+void group_volume_by_type(const uint16_t* type_id, const int32_t* volume, int n, long long* items, long long* volume_sum) {
+    for (int i = 0; i < n; i++) {
+        items[type_id[i]]++;
+        volume_sum[type_id[i]] += volume[i];
+    }
+}
+
+/*
+ * 函数：sum_temperature_band
+ * 功能：聚合内核：统计温度在[lo, hi]之间的食物数和总体积；循环里没有分支，编译器可以向量化
+ * 参数：temperature、volume - 两列，各n项
+ * 参数：items、volume_sum - 输出
+ */
+void sum_temperature_band(const int16_t* temperature, const int32_t* volume, int n, int lo, int hi, long long* items, long long* volume_sum) {
+    long long count = 0, sum = 0;
+    for (int i = 0; i < n; i++) {
+        int in = (temperature[i] >= lo) & (temperature[i] <= hi);
+        count += in;
+        sum += in ? volume[i] : 0;
+    }
+    *items = count;
+    *volume_sum = sum;
+}
+
+// 结构体：报表中一个种类的合计
+typedef struct type_total {
+    uint16_t type_id;
+    long long items;
+    long long volume;
+} type_total;
+
+int type_total_cmp(const void* a, const void* b) {  // 按总体积降序，相同时按种类编号
+    const type_total* x = (const type_total*)a;
+    const type_total* y = (const type_total*)b;
+    if (x->volume != y->volume) return x->volume > y->volume ? -1 : 1;
+    return (int)x->type_id - (int)y->type_id;
+}
+
+/*
+ * 函数：warehouse_report
+ * 功能：刷新仓库的列式快照，在快照上按种类汇总体积、按温度段汇总食物、统计各冰柜的使用率并输出
+ * 参数：warehouse_path - 仓库路径
+ */
+void warehouse_report(const char* warehouse_path) {
+    double start = now_ms();
+    warehouse_snapshot s;
+    int reloaded;
+    if (!warehouse_snapshot_refresh(warehouse_path, &s, &reloaded)) {
+        printf("Error: Cannot read warehouse %s\n", warehouse_path);
+        return;
+    }
+    double refreshed = now_ms();
+    double stats = stats_start();
+
+    long long* type_items = (long long*)calloc(65536, sizeof(long long));  // 以种类编号为下标，FOOD_TYPE_NONE 也在范围内
+    long long* type_volume = (long long*)calloc(65536, sizeof(long long));
+    type_total* types = (type_total*)malloc(65536 * sizeof(type_total));
+    if (type_items == NULL || type_volume == NULL || types == NULL) {
+        printf("Error: Out of memory\n");
+        free(type_items);
+        free(type_volume);
+        free(types);
+        snapshot_free(&s);
+        return;
+    }
+    group_volume_by_type(s.type_id, s.volume, s.item_count, type_items, type_volume);
+    int type_count = 0;
+    for (int id = 0; id < 65536; id++) {
+        if (type_items[id] == 0) continue;
+        types[type_count].type_id = (uint16_t)id;
+        types[type_count].items = type_items[id];
+        types[type_count].volume = type_volume[id];
+        type_count++;
+    }
+    qsort(types, type_count, sizeof(type_total), type_total_cmp);
+
+    long long band_items[SNAPSHOT_BANDS], band_volume[SNAPSHOT_BANDS], banded = 0;
+    for (int b = 0; b < SNAPSHOT_BANDS; b++) {
+        int lo = FREZZER_TEMP_MIN + b * SNAPSHOT_BAND_WIDTH;
+        int hi = lo + SNAPSHOT_BAND_WIDTH - 1 < FREZZER_TEMP_MAX ? lo + SNAPSHOT_BAND_WIDTH - 1 : FREZZER_TEMP_MAX;
+        sum_temperature_band(s.temperature, s.volume, s.item_count, lo, hi, &band_items[b], &band_volume[b]);
+        banded += band_items[b];
+    }
+
+    int utilisation[11] = {0};  // 使用率每10%一格，最后一格是装满的
+    long long used_total = 0;
+    for (int i = 0; i < s.freezer_count; i++) {
+        long long used = FREZZER_CAPACITY - (long long)s.freezers[i].summary.available_volume;
+        if (used < 0) used = 0;
+        if (used > FREZZER_CAPACITY) used = FREZZER_CAPACITY;
+        utilisation[used * 10 / FREZZER_CAPACITY]++;
+        used_total += used;
+    }
+    stats_stop(STATS_TIMER_QUERY, stats);
+    double aggregated = now_ms();
+
+    printf("\n=== Report: %s ===\n", warehouse_path);
+    printf("%d freezer(s), %d item(s); snapshot %.2f ms (%d freezer(s) reloaded), aggregates %.2f ms\n",
+        s.freezer_count, s.item_count, refreshed - start, reloaded, aggregated - refreshed);
+    printf("\nVolume by type:\n  %-20s %12s %14s\n", "Type", "Items", "Volume");
+    for (int i = 0; i < type_count; i++) {
+        printf("  %-20s %12lld %14lld\n", food_type_name(types[i].type_id), types[i].items, types[i].volume);
+    }
+    if (type_count == 0) printf("  (Empty)\n");
+    printf("\nTemperature bands:\n  %-20s %12s %14s\n", "Band (C)", "Items", "Volume");
+    for (int b = 0; b < SNAPSHOT_BANDS; b++) {
+        int lo = FREZZER_TEMP_MIN + b * SNAPSHOT_BAND_WIDTH;
+        int hi = lo + SNAPSHOT_BAND_WIDTH - 1 < FREZZER_TEMP_MAX ? lo + SNAPSHOT_BAND_WIDTH - 1 : FREZZER_TEMP_MAX;
+        char band[32];
+        sprintf(band, "%d..%d", lo, hi);
+        printf("  %-20s %12lld %14lld\n", band, band_items[b], band_volume[b]);
+    }
+    if (banded < s.item_count) printf("  %-20s %12lld\n", "(out of range)", s.item_count - banded);  // 只会来自未校验的文件
+    printf("\nFreezer utilisation:\n");
+    for (int k = 0; k <= 10; k++) {
+        char range[16];
+        if (k < 10) sprintf(range, "%d-%d%%", k * 10, k * 10 + 9);
+        else strcpy(range, "100%");
+        printf("  %-20s %12d\n", range, utilisation[k]);
+    }
+    long long capacity_total = (long long)s.freezer_count * FREZZER_CAPACITY;
+    printf("  Used %lld of %lld (%.1f%%)\n", used_total, capacity_total, capacity_total > 0 ? used_total * 100.0 / capacity_total : 0.0);
+
+    free(type_items);
+    free(type_volume);
+    free(types);
+    snapshot_free(&s);
+}
+
+// 结构体：一屏输出的缓冲区，内容攒在一起一次写出
+typedef struct screen_buffer {
+    char data[65536];
+    size_t used;
+} screen_buffer;
+
+void screen_flush(screen_buffer* b) {  // 把缓冲区中的内容一次写到标准输出
+    fwrite(b->data, 1, b->used, stdout);
+    fflush(stdout);
+    b->used = 0;
+}
+
+void screen_printf(screen_buffer* b, const char* format, ...) {  // 格式化追加到缓冲区，放不下时先写出已有内容
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(b->data + b->used, sizeof(b->data) - b->used, format, args);
+    va_end(args);
+    if (n < 0) return;
+    if ((size_t)n >= sizeof(b->data) - b->used) {  // 放不下：先写出，再重新格式化
+        b->data[b->used] = '\0';
+        screen_flush(b);
+        va_start(args, format);
+        n = vsnprintf(b->data, sizeof(b->data), format, args);
+        va_end(args);
+        if (n < 0) return;
+        if ((size_t)n >= sizeof(b->data)) n = sizeof(b->data) - 1;  // 单条输出超过缓冲区时截断
+    }
+    b->used += (size_t)n;
+}
+
+int freezer_page_start(const frezzer* f, int first) {  // 把一页的起始下标限制在有效范围内：越过末尾时退到最后一页
+    if (first >= f->store.count) first = f->store.count - freezer_page_size;
+    return first < 0 ? 0 : first;
+}
+
+/*
+ * 函数：show_freezer_content
+ * 功能：显示三级菜单（食物列表），只列出从first开始的一页食物，整屏内容攒在缓冲区中一次写出
+ * 参数：f - 指向冰柜结构体的指针
+ * 参数：freezer_name - 冰柜的名称
+ * 参数：first - 这一页第一个食物的显示下标（从0开始）
+ */
+void show_freezer_content(frezzer* f, const char* freezer_name, int first) {
+    static screen_buffer screen;  // 缓冲区较大，不放在栈上
+    first = freezer_page_start(f, first);
+    int last = first + freezer_page_size < f->store.count ? first + freezer_page_size : f->store.count;
+
+    screen_printf(&screen, "\n=== Freezer: %s ===\n", freezer_name);
+    screen_printf(&screen, "Temperature: %d C\n", f->frezzer_temperature);
+    screen_printf(&screen, "Available Volume: %d / %d\n", f->frezzer_available_volume, FREZZER_CAPACITY);
+    screen_printf(&screen, "Food List (Sorted by Volume Desc), showing %d-%d of %d:\n", last > first ? first + 1 : 0, last, f->store.count);
+    screen_printf(&screen, "%-20s %-10s %-10s %-10s\n", "Name", "Type", "Volume", "Temp");
+    screen_printf(&screen, "----------------------------------------------------\n");
+
+    int idx = first;  // 变量：食物序号；只定位一次（O(log n)），之后沿显示链表往后走，只格式化这一页
+    for (int i = food_store_slot_at(&f->store, first); i != -1 && idx < last; i = f->store.links[i].next) {
+        const food_record* curr = &f->store.items[i];
+        screen_printf(&screen, "%d. %-17s %-10s %-10d %-10d\n", ++idx, food_record_name(&f->store, curr), food_type_name(curr->type_id), curr->volume, curr->temperature);
+    }
+
+    // Show options
+    screen_printf(&screen, "\n");
+    screen_printf(&screen, "========== Freezer Menu ==========\n");
+    screen_printf(&screen, " [0] Add Food\n");
+    screen_printf(&screen, " [1] Delete Food\n");
+    screen_printf(&screen, " [2] Modify Food\n");
+    screen_printf(&screen, " [3] Query Food\n");
+    screen_printf(&screen, " [4] Export as Text\n");
+    screen_printf(&screen, " [5] Next Page\n");
+    screen_printf(&screen, " [6] Previous Page\n");
+    screen_printf(&screen, " [7] Go to Item\n");
+    screen_printf(&screen, " [8] Show Top N\n");
+    screen_printf(&screen, " [-1] Return\n");
+    screen_printf(&screen, "==================================\n");
+    screen_printf(&screen, "Please enter a number to operate: ");
+    screen_flush(&screen);
+}
+
+#ifndef _WIN32
+#define UNLINK_CHUNK 64  // 并行删除时每个任务删除的文件数
+#define UNLINK_THREADS 8  // 并行删除最多用的线程数，同一个目录的删除在文件系统里要排队，线程再多也快不了
+
+// 结构体：一个目录中待删除的文件，名称连续存放在一块内存中，不必每项单独申请
+typedef struct unlink_batch {
+    int dir_fd;  // 文件所在的目录
+    char* names;  // 各名称依次存放，各以'\0'结尾
+    size_t used;
+    size_t capacity;
+    size_t* offsets;  // 每个名称在names中的偏移
+    int count;
+    int offset_capacity;
+} unlink_batch;
+
+int unlink_batch_add(unlink_batch* b, const char* name) {  // 记下一个待删除的文件，内存不足返回0
+    size_t len = strlen(name) + 1;
+    if (b->count == b->offset_capacity) {
+        int new_capacity = b->offset_capacity ? b->offset_capacity * 2 : 256;
+        size_t* temp = (size_t*)realloc(b->offsets, (size_t)new_capacity * sizeof(size_t));
+        if (temp == NULL) return 0;
+        b->offsets = temp;
+        b->offset_capacity = new_capacity;
+    }
+    if (b->used + len > b->capacity) {
+        size_t new_capacity = b->capacity ? b->capacity * 2 : 8192;
+        if (new_capacity < b->used + len) new_capacity = b->used + len;
+        char* temp = (char*)realloc(b->names, new_capacity);
+        if (temp == NULL) return 0;
+        b->names = temp;
+        b->capacity = new_capacity;
+    }
+    memcpy(b->names + b->used, name, len);
+    b->offsets[b->count++] = b->used;
+    b->used += len;
+    return 1;
+}
+
+void unlink_task(void* arg, int task, int thread) {  // 并行任务：删除第task组文件
+    (void)thread;  // 各组互不相干，不需要按线程分的缓冲区
+    const unlink_batch* b = (const unlink_batch*)arg;
+    int end = (task + 1) * UNLINK_CHUNK < b->count ? (task + 1) * UNLINK_CHUNK : b->count;
+    for (int i = task * UNLINK_CHUNK; i < end; i++) unlinkat(b->dir_fd, b->names + b->offsets[i], 0);
+}
+
+/*
+ * 函数：remove_dir_at
+ * 功能：删除 parent_fd 目录下名为 name 的目录及其中全部内容；文件类型取自目录项（d_type），不用逐个 stat，
+ *       文件全部按相对目录描述符的名称删除（unlinkat），不用拼路径，文件多时用线程池并行删除
+ * 参数：parent_fd - 上级目录的描述符（AT_FDCWD 表示当前目录）
+ * 参数：name - 目录名（相对于 parent_fd）
+ * 返回：目录已删除返回1，否则返回0
+ */
+int remove_dir_at(int parent_fd, const char* name) {
+    int fd = openat(parent_fd, name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+    if (fd == -1) return 0;
+    DIR* d = fdopendir(fd);
+    if (d == NULL) {
+        close(fd);
+        return 0;
+    }
+
+    unlink_batch b;
+    memset(&b, 0, sizeof(b));
+    b.dir_fd = fd;
+    for (struct dirent* e = readdir(d); e != NULL; e = readdir(d)) {
+        if (!strcmp(e->d_name, ".") || !strcmp(e->d_name, "..")) continue;
+        int is_dir = e->d_type == DT_DIR;
+        if (e->d_type == DT_UNKNOWN) {  // 有的文件系统不填类型，只能再查一次
+            struct stat st;
+            stats_count(STATS_FILES_STATED, 1);
+            is_dir = fstatat(fd, e->d_name, &st, AT_SYMLINK_NOFOLLOW) == 0 && S_ISDIR(st.st_mode);
+        }
+        if (is_dir) remove_dir_at(fd, e->d_name);  // 子目录递归删除
+        else if (!unlink_batch_add(&b, e->d_name)) unlinkat(fd, e->d_name, 0);  // 内存不足时当场删除
+    }
+
+    int tasks = (b.count + UNLINK_CHUNK - 1) / UNLINK_CHUNK;
+    int threads = cpu_count();
+    if (threads > UNLINK_THREADS) threads = UNLINK_THREADS;
+    if (threads > tasks) threads = tasks;
+    if (tasks > 0) run_parallel(tasks, threads, unlink_task, &b);  // 只有一组时就在当前线程删除
+    free(b.names);
+    free(b.offsets);
+    closedir(d);  // 同时关闭 fd
+    return unlinkat(parent_fd, name, AT_REMOVEDIR) == 0;
+}
+#endif
+
+/*
+ * 函数：remove_dir_recursive
+ * 功能：递归删除目录及其包含的所有文件和子目录
+ * 参数：path - 要删除的目录路径
+ */
+void remove_dir_recursive(const char *path) {
+#ifndef _WIN32
+    remove_dir_at(AT_FDCWD, path);
+#else
+    DIR *d = opendir(path); // 打开目录
+    size_t path_len = strlen(path);
+    struct dirent *p;
+
+    if (!d) return; // 打开失败直接返回
+
+    for (p = readdir(d); p != NULL; p = readdir(d)) {
+        char *buf;
+        size_t len;
+
+        // 跳过 . 和 ..
+        if (!strcmp(p->d_name, ".") || !strcmp(p->d_name, ".."))
+            continue;
+
+        len = path_len + strlen(p->d_name) + 2;
+        buf = malloc(len); // 分配路径缓冲区内存
+
+        if (buf) {
+            sprintf(buf, "%s/%s", path, p->d_name);
+            struct stat temp;
+            if (stat_file(buf, &temp) == 0) {
+                // 如果是目录则递归删除，否则直接删除文件
+                if (S_ISDIR(temp.st_mode))
+                    remove_dir_recursive(buf);
+                else
+                    remove(buf);
+            }
+            free(buf); // 释放缓冲区
+        }
+    }
+    closedir(d); // 关闭目录
+    _rmdir(path); // 删除空目录本身
+#endif
+}
+
+void* tombstone_reclaim_main(void* arg) {  // 后台线程：删除一个墓碑目录
+    char* path = (char*)arg;
+    remove_dir_recursive(path);
+    free(path);
+    return NULL;
+}
 
-// 结构体：食物信息
-typedef struct food {
-    char food_name[100];  // 食物名称，最大长度99个字符
-    char food_type[100];  // 食物种类（如蔬菜、肉类、水果）
-    int food_volume;  // 食物体积
-    int food_temperature;  // 食物保存的温度
-}food;
+void tombstone_reclaim_start(const char* path) {  // 起一个后台线程删除墓碑目录，线程起不来时当场删除
+    char* copy = (char*)malloc(strlen(path) + 1);
+    pthread_t thread;
+    if (copy != NULL) {
+        strcpy(copy, path);
+        if (pthread_create(&thread, NULL, tombstone_reclaim_main, copy) == 0) {
+            pthread_detach(thread);
+            return;
+        }
+        free(copy);
+    }
+    remove_dir_recursive(path);
+}
 
-// 结构体：链表节点
-typedef struct node {
-    food data;  // 数据域，一个food类型的变量
-    struct node* next;  // 指针域，指向下一个节点
-} node;
+/*
+ * 函数：delete_warehouse
+ * 功能：删除仓库；默认先在同一目录下改名为墓碑（.deleted.仓库名.时间），仓库立刻从列表中消失，由后台线程慢慢删除；
+ *       程序在删完之前退出也没关系，下次启动时 reclaim_tombstones 会接着删
+ * 参数：path - 仓库路径
+ */
+void delete_warehouse(const char* path) {
+    if (delete_in_background) {
+        char tombstone[700];
+        const char* name = strrchr(path, '/');
+        int parent_len = name != NULL ? (int)(name - path) + 1 : 0;
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        sprintf(tombstone, "%.*s.deleted.%s.%lld%09ld", parent_len, path, path + parent_len, (long long)ts.tv_sec, (long)ts.tv_nsec);
+        if (rename(path, tombstone) == 0) {
+            tombstone_reclaim_start(tombstone);
+            return;
+        }
+    }
+    remove_dir_recursive(path);  // 不在后台删或改名失败时当场删除
+}
 
-// 结构体：冰柜信息
-typedef struct frezzer {
-    node* head;  // 头指针
-    node* tail;  // 尾指针
-    int frezzer_temperature;  // 冰柜的温度
-    int frezzer_available_volume;  // 冰柜的可用容积
-} frezzer;
+void reclaim_tombstones() {  // 启动时接着删除上次没删完的墓碑
+    DIR* dir = opendir("data");
+    if (dir == NULL) return;
+    for (struct dirent* entry = readdir(dir); entry != NULL; entry = readdir(dir)) {
+        char path[600];
+        if (strncmp(entry->d_name, ".deleted.", 9) != 0 || strlen(entry->d_name) > 500) continue;
+        sprintf(path, "data/%s", entry->d_name);
+        tombstone_reclaim_start(path);
+    }
+    closedir(dir);
+}
 
-void frezzer_init(frezzer* f) {  // 初始化冰柜结构体
-    f->head = NULL;  // 初始化头指针为空
-    f->tail = NULL;  // 初始化尾指针为空
-    f->frezzer_temperature = 10;  // 最高允许温度10度
-    f->frezzer_available_volume = 100;  // 可用容积最大值100
+/*
+ * Function: clear_buffer
+ * Purpose: Clear the input buffer to prevent infinite loops on invalid input
+ */
+void clear_buffer() {
+    int c;
+    for (c = getchar(); c != '\n' && c != EOF; c = getchar());
 }
 
-node* create_node(node** head, node** tail) {  //新建链节并尾插，传入head和tail的二级指针
-    node* temp = (node*)malloc(sizeof(node)); // 新建节点
-    temp->next = NULL; // 仅初始化指针
+// 结构体：批处理中的一条命令
+typedef struct batch_command {
+    int line;  // 所在行号，报错用
+    int freezer;  // 目标冰柜在冰柜路径表中的下标，-1表示还没有选定（冰柜名写 * 时由 place_batch_adds 选择）
+    int warehouse;  // 仓库编号
+    char op;  // 'A' 添加，'D' 删除（按名称）
+    food item;  // 添加的食物；删除时只用名称
+} batch_command;
 
-    if (*head == NULL) {
-        // 如果链表为空，head和tail指向新节点
-        *head = temp;
-        *tail = temp;
-    } else {
-        // 若链表不空，则尾插，并更新tail
-        (*tail)->next = temp;
-        *tail = temp;
+int batch_split(char* line, char** fields, int max) {  // 按逗号切分一行，去掉每个字段两端的空白，返回字段数（超过max个时返回max+1）
+    int n = 0;
+    for (char* p = line; ; ) {
+        for (; *p == ' ' || *p == '\t'; p++);
+        char* end = p;
+        for (; *end != ',' && *end != '\0' && *end != '\n' && *end != '\r'; end++);
+        char next = *end;
+        *end = '\0';
+        for (char* back = end; back > p && (back[-1] == ' ' || back[-1] == '\t'); ) *--back = '\0';
+        if (n == max) return max + 1;
+        fields[n++] = p;
+        if (next != ',') return n;
+        p = end + 1;
     }
+}
+
+int batch_parse_int(const char* text, int* out) {  // 整个字段必须是一个整数，成功返回1
+    char* end;
+    long v = strtol(text, &end, 10);
+    if (*text == '\0' || *end != '\0' || v < -2147483647L - 1 || v > 2147483647L) return 0;
+    *out = (int)v;
+    return 1;
+}
 
-    return temp;  // 返回指向新节点的指针
+int batch_word_valid(const char* text) {  // 名称、种类不能为空、不能超过99个字符、不能含空白（文本格式按空白分隔字段）
+    size_t len = strlen(text);
+    return len > 0 && len < 100 && strpbrk(text, " \t") == NULL;
 }
 
+/*
+ * 函数：batch_parse_line
+ * 功能：解析批处理的一行：add,仓库编号,冰柜名,名称,种类,体积,温度 或 remove,仓库编号,冰柜名,名称
+ *       添加时冰柜名可以写 *，表示放进这个仓库中任意一个放得下的冰柜
+ * 参数：line - 一行内容（会被改写）
+ * 参数：c - 输出的命令
+ * 参数：freezers - 冰柜路径表，新出现的冰柜加在末尾
+ * 参数：error - 出错时输出错误说明
+ * 返回：解析成功返回1，空行、注释或表头返回0，出错返回-1
+ */
+int batch_parse_line(char* line, batch_command* c, freezer_file_list* freezers, const char** error) {
+    char* fields[7];
+    int n = batch_split(line, fields, 7);
+    if ((n == 1 && fields[0][0] == '\0') || fields[0][0] == '#' || strcmp(fields[0], "op") == 0) return 0;
+
+    int warehouse;
+    if (strcmp(fields[0], "add") == 0 && n == 7) c->op = 'A';
+    else if (strcmp(fields[0], "remove") == 0 && n == 4) c->op = 'D';
+    else { *error = "expected add,warehouse,freezer,name,type,volume,temp or remove,warehouse,freezer,name"; return -1; }
+    if (!batch_parse_int(fields[1], &warehouse)) { *error = "warehouse must be a number"; return -1; }
+    if (!batch_word_valid(fields[2]) || strchr(fields[2], '/') != NULL) { *error = "invalid freezer name"; return -1; }
+    if (c->op == 'D' && strcmp(fields[2], "*") == 0) { *error = "remove needs a freezer name"; return -1; }
+    if (!batch_word_valid(fields[3])) { *error = "name must be 1-99 characters without spaces"; return -1; }
+    strcpy(c->item.food_name, fields[3]);
+    if (c->op == 'A') {
+        if (!batch_word_valid(fields[4])) { *error = "type must be 1-99 characters without spaces"; return -1; }
+        if (!batch_parse_int(fields[5], &c->item.food_volume) || c->item.food_volume < 0 || c->item.food_volume > FREZZER_CAPACITY) { *error = "volume must be a number from 0 to " FREZZER_STR(FREZZER_CAPACITY); return -1; }
+        if (!batch_parse_int(fields[6], &c->item.food_temperature) || c->item.food_temperature < FREZZER_TEMP_MIN || c->item.food_temperature > FREZZER_TEMP_MAX) { *error = "temperature must be a number from " FREZZER_STR(FREZZER_TEMP_MIN) " to " FREZZER_STR(FREZZER_TEMP_MAX); return -1; }
+        strcpy(c->item.food_type, fields[4]);
+    }
 
-void free_list(node* head) {  //释放整个链表，不释放头指针（在frezzer里），传入头指针
-    for (node *temp = head, *next; temp != NULL; temp = next) { // 当前处理的节点
-        next = temp->next;  // 保存下一个节点的地址
-        free(temp);  // 释放当前节点
+    c->warehouse = warehouse;
+    if (strcmp(fields[2], "*") == 0) {
+        c->freezer = -1;
+        return 1;
+    }
+    char path[600];
+    sprintf(path, "data/warehouse_%d/%s.txt", warehouse, fields[2]);
+    for (c->freezer = freezers->count - 1; c->freezer >= 0 && strcmp(freezers->paths[c->freezer], path) != 0; c->freezer--);  // 同一个冰柜的命令通常连在一起，从后往前找
+    if (c->freezer == -1) {
+        if (!freezer_file_list_add(freezers, path)) { *error = "out of memory"; return -1; }
+        c->freezer = freezers->count - 1;
     }
+    return 1;
 }
 
-void calculate_freezer_status(frezzer* f) {  // 计算冰柜的剩余容积和温度，更改冰柜中食物时调用 传入指向冰柜的指针 无返
-    int used_volume = 0;  // 记录已使用的容积
-    int min_temp = 10;  // 记录最低温度，初值为10
+int batch_cmp(const void* a, const void* b) {  // 按冰柜分组，组内保持行号顺序
+    const batch_command *x = a, *y = b;
+    if (x->freezer != y->freezer) return x->freezer - y->freezer;
+    return x->line - y->line;
+}
 
-    for (node* temp = f->head; temp != NULL; temp = temp->next) { // 遍历冰柜
-        used_volume += temp->data.food_volume; // 累加体积
-        if (temp->data.food_temperature < min_temp) {  // 求最小温度
-            min_temp = temp->data.food_temperature;
-        }
-    }
+// 结构体：按冰柜下标排列的线段树，每个节点存子区间中最大的可用容积，用来在O(log n)内找到第一个放得下的冰柜
+typedef struct space_tree {
+    int* max;  // max[1]为根，节点i的子节点为2i和2i+1，叶子从size开始
+    int size;  // 叶子数（不小于冰柜数的2的幂）
+} space_tree;
 
-    f->frezzer_available_volume = 100 - used_volume;  // 更新冰柜体积
-    f->frezzer_temperature=min_temp;// 更新冰柜温度
+int space_tree_build(space_tree* t, const int* available, int n) {  // 用各冰柜的可用容积建树，多出的叶子为-1（什么都放不下），成功返回1
+    for (t->size = 1; t->size < n; t->size *= 2);
+    t->max = (int*)malloc(2 * (size_t)t->size * sizeof(int));
+    if (t->max == NULL) return 0;
+    for (int i = 0; i < t->size; i++) t->max[t->size + i] = i < n ? available[i] : -1;
+    for (int i = t->size - 1; i >= 1; i--) t->max[i] = t->max[2 * i] > t->max[2 * i + 1] ? t->max[2 * i] : t->max[2 * i + 1];
+    return 1;
 }
 
-int cmp(const void *a, const void *b) {  // qsort排序单链表用的排序函数
-    const food *food_a = a, *food_b = b;
-    return food_b->food_volume - food_a->food_volume; // 降序排序
+int space_tree_first_fit(const space_tree* t, int need) {  // 下标最小的可用容积不少于need的冰柜，没有返回-1
+    if (t->max[1] < need) return -1;
+    int node = 1;
+    for (; node < t->size; ) node = t->max[2 * node] >= need ? 2 * node : 2 * node + 1;  // 左边放得下就往左走
+    return node - t->size;
 }
 
-void sort_food_list(frezzer* f) {  //对冰柜中的食物按照体积进行 降序排序 传入指向冰柜变量的指针
-    if (f->head == NULL || f->head->next == NULL) return; // 若为空链表/单节点，不用排序
+void space_tree_set(space_tree* t, int index, int available) {  // 修改一个冰柜的可用容积，沿路更新到根
+    int node = t->size + index;
+    t->max[node] = available;
+    for (node /= 2; node >= 1; node /= 2) t->max[node] = t->max[2 * node] > t->max[2 * node + 1] ? t->max[2 * node] : t->max[2 * node + 1];
+}
 
-    food temp_data[100];  // 暂时记录链表中全部数据
-    int tag = 0;  // 临时变量，用两次
+int place_cmp(const void* a, const void* b) {  // 待选冰柜的命令排在最前，按仓库分组，组内体积从大到小，体积相同时按行号
+    const batch_command *x = a, *y = b;
+    if ((x->freezer == -1) != (y->freezer == -1)) return x->freezer == -1 ? -1 : 1;
+    if (x->warehouse != y->warehouse) return x->warehouse - y->warehouse;
+    if (x->item.food_volume != y->item.food_volume) return y->item.food_volume - x->item.food_volume;
+    return x->line - y->line;
+}
 
-    // 1. 复制链表数据到数组（无初始化）
-    for (node* temp = f->head; temp != NULL; temp = temp->next) {
-        temp_data[tag++] = temp->data;
-    }
+/*
+ * 函数：place_batch_adds
+ * 功能：为冰柜名写 * 的添加命令选择冰柜（首次适应递减）：按仓库分组，体积从大到小依次放进第一个放得下的冰柜
+ *       各冰柜的可用容积来自仓库的摘要缓存，先扣掉同一批中已指定冰柜的添加；温度范围对所有冰柜相同，解析时已检查
+ *       找冰柜用线段树，n个食物、m个冰柜共 O(n log n + n log m)
+ * 参数：c - 全部命令（会被重新排序）
+ * 参数：n - 命令数量
+ * 参数：freezers - 冰柜路径表，选中的冰柜不在表中时加在末尾
+ * 返回：放不下的命令数，这些命令的冰柜保持为-1，执行时跳过
+ */
+int place_batch_adds(batch_command* c, int n, freezer_file_list* freezers) {
+    qsort(c, n, sizeof(batch_command), place_cmp);
+    int errors = 0;
+    for (int start = 0, end; start < n && c[start].freezer == -1; start = end) {
+        for (end = start; end < n && c[end].freezer == -1 && c[end].warehouse == c[start].warehouse; end++);
+        char warehouse_path[600];
+        sprintf(warehouse_path, "data/warehouse_%d", c[start].warehouse);
+        summary_cache summaries;
+        int* available = NULL;
+        int* list_index = NULL;  // 每个冰柜在冰柜路径表中的下标，第一次选中时才加进表
+        space_tree tree = {NULL, 0};
+        if (!warehouse_model_summaries(warehouse_path, &summaries) || summaries.count == 0) {
+            for (int i = start; i < end; i++) printf("line %d: warehouse_%d has no freezers\n", c[i].line, c[i].warehouse);
+            errors += end - start;
+            free(summaries.items);
+            continue;
+        }
+        available = (int*)malloc((size_t)summaries.count * sizeof(int));
+        list_index = (int*)malloc((size_t)summaries.count * sizeof(int));
+        if (available == NULL || list_index == NULL) {
+            for (int i = start; i < end; i++) printf("line %d: out of memory\n", c[i].line);
+            errors += end - start;
+            free(available);
+            free(list_index);
+            free(summaries.items);
+            continue;
+        }
+        for (int i = 0; i < summaries.count; i++) {
+            available[i] = summaries.items[i].available_volume;
+            list_index[i] = -1;
+        }
 
-    // 2. 用实际节点数 tag 替代固定 100
-    qsort(temp_data, tag, sizeof(food), cmp);
+        size_t prefix = strlen(warehouse_path);  // 同一批中直接写了冰柜名的添加也要占地方
+        for (int i = 0; i < n; i++) {
+            if (c[i].freezer == -1 || c[i].op != 'A') continue;
+            const char* path = freezers->paths[c[i].freezer];
+            if (strncmp(path, warehouse_path, prefix) != 0 || path[prefix] != '/') continue;
+            freezer_summary key;
+            strcpy(key.file_name, path + prefix + 1);
+            const freezer_summary* e = (const freezer_summary*)bsearch(&key, summaries.items, summaries.count, sizeof(freezer_summary), summary_cmp);
+            if (e == NULL) {  // 文本文件名没找到，再找二进制文件名
+                strcpy(strrchr(key.file_name, '.'), ".frz");
+                e = (const freezer_summary*)bsearch(&key, summaries.items, summaries.count, sizeof(freezer_summary), summary_cmp);
+            }
+            if (e != NULL) available[e - summaries.items] -= c[i].item.food_volume;
+        }
 
-    // 3. 复制回链表
-    tag = 0;
-    for (node* temp = f->head; temp != NULL; temp = temp->next) {
-        temp->data = temp_data[tag++];
+        if (!space_tree_build(&tree, available, summaries.count)) {
+            for (int i = start; i < end; i++) printf("line %d: out of memory\n", c[i].line);
+            errors += end - start;
+        } else {
+            for (int i = start; i < end; i++) {
+                int k = space_tree_first_fit(&tree, c[i].item.food_volume);
+                if (k == -1) {
+                    printf("line %d: no freezer in warehouse_%d has room for %s (volume %d)\n", c[i].line, c[i].warehouse, c[i].item.food_name, c[i].item.food_volume);
+                    errors++;
+                    continue;
+                }
+                available[k] -= c[i].item.food_volume;
+                space_tree_set(&tree, k, available[k]);
+                if (list_index[k] == -1) {
+                    char path[600];
+                    sprintf(path, "%s/%s", warehouse_path, summaries.items[k].file_name);
+                    strcpy(strrchr(path, '.'), ".txt");
+                    if (!freezer_file_list_add(freezers, path)) {
+                        printf("line %d: out of memory\n", c[i].line);
+                        errors++;
+                        continue;
+                    }
+                    list_index[k] = freezers->count - 1;
+                }
+                c[i].freezer = list_index[k];
+            }
+        }
+        free(tree.max);
+        free(available);
+        free(list_index);
+        free(summaries.items);
     }
+    return errors;
 }
 
-void save_freezer_to_file(char* filepath, frezzer* f) {  // 将链表中的内容写入文件，传入：文件路径 指向冰柜结构体的指针
-    FILE* fp = fopen(filepath, "w");  // 以写模式打开文件
-    if (fp == NULL) {  // 若找不到，则报错并返回
-        printf("Error: Cannot save file %s\n", filepath);
-        return;
+/*
+ * 函数：batch_apply
+ * 功能：把一个冰柜的全部命令一次做完：先按名称删除已有的食物，再对所有添加做一次容量检查，批量追加后只排序一次、只保存一次
+ * 参数：f - 用来装载冰柜的冰柜结构体（已初始化，内存在各组之间复用）
+ * 参数：path - 冰柜的文本文件路径
+ * 参数：c - 这个冰柜的命令，按行号排好
+ * 参数：n - 命令数量
+ * 返回：出错的行数
+ */
+int batch_apply(frezzer* f, const char* path, const batch_command* c, int n) {
+    char name[600];  // 显示用的 仓库/冰柜
+    strcpy(name, path + (strncmp(path, "data/", 5) == 0 ? 5 : 0));
+    char* dot = strrchr(name, '.');
+    if (dot) *dot = '\0';
+    int lock = freezer_lock(path);  // 读取到保存之间不让别的进程改这个冰柜
+    if (!freezer_exists(path)) {
+        for (int i = 0; i < n; i++) printf("line %d: freezer %s not found\n", c[i].line, name);
+        freezer_unlock(lock);
+        return n;
     }
+    load_freezer_from_file(path, f);
 
-    for (node* temp = f->head; temp != NULL; temp = temp->next) {  // 遍历链表写入文件，文件中的顺序为：名字 类型 体积 温度\n
-        fprintf(fp, "%s %s %d %d\n", 
-            temp->data.food_name, 
-            temp->data.food_type, 
-            temp->data.food_volume, 
-            temp->data.food_temperature);
+    // 1. 删除：只在批处理之前已有的食物中找（同一批新加的食物还没放进去）
+    int errors = 0, removed = 0, added = 0, add_count = 0;
+    long long add_volume = 0;
+    for (int i = 0; i < n; i++) {
+        if (c[i].op == 'A') {
+            add_count++;
+            add_volume += c[i].item.food_volume;
+            continue;
+        }
+        int slot = food_store_find_name(&f->store, -1, c[i].item.food_name);
+        if (slot == -1) {
+            printf("line %d: no food named %s in %s\n", c[i].line, c[i].item.food_name, name);
+            errors++;
+        } else {
+            frezzer_remove_food(f, slot);
+            removed++;
+        }
     }
-    fclose(fp);  // 关闭文件
-}
 
-void load_freezer_from_file(char* filepath, frezzer* f) {  // 读取指定文件，生成链表，并加载数据到链表中，传入：文件路径 指向冰柜结构体的指针
-    frezzer_init(f); // 先初始化冰柜
-    FILE* fp = fopen(filepath, "r"); // 以读模式打开文件，FILE为读取文件用的数据类型
-    if (fp == NULL) {
-        // 如果文件不存在，则报错并返回
-        printf("Error: Cannot find file %s\n", filepath);
-        return;
+    // 2. 所有添加只做一次容量检查，放不下时整批拒绝
+    if (add_volume > f->frezzer_available_volume) {
+        for (int i = 0; i < n; i++) {
+            if (c[i].op == 'A') printf("line %d: rejected, adds for %s need %lld but only %d is available\n", c[i].line, name, add_volume, f->frezzer_available_volume);
+        }
+        errors += add_count;
+    } else if (add_count > 0) {
+        food_store_reserve(&f->store, f->store.used + add_count);  // 一次扩够
+        for (int i = 0; i < n; i++) {
+            if (c[i].op != 'A') continue;
+            int slot = food_store_add(&f->store, &c[i].item);
+            if (slot == -1) {
+                printf("line %d: out of memory\n", c[i].line);
+                errors++;
+                continue;
+            }
+            frezzer_account(f, c[i].item.food_volume, c[i].item.food_temperature, 1);
+            added++;
+        }
+        sort_food_list(f);  // 3. 只排序一次
     }
 
-    char name[100], type[100];  // 记录读到的名称和类型
-    int vol, temp;  // 记录读到的体积和温度
-    for (; fscanf(fp, "%s %s %d %d", name, type, &vol, &temp) == 4; ) {  // 循环读取文件内容，每次读取4项（一行）数据
-        node* new_node = create_node(&(f->head), &(f->tail)); // 创建新节点，接下来读取并将内容写入新节点中
-        strcpy(new_node->data.food_name, name);
-        strcpy(new_node->data.food_type, type);
-        new_node->data.food_volume = vol;
-        new_node->data.food_temperature = temp;
+    // 4. 只保存一次：写出新的基础文件，原来的日志已包含在内，随之删掉
+    int saved = 1;
+    if (removed + added > 0) {
+        saved = save_freezer_to_file(path, f);
+        if (saved) {
+            char journal_path[610];
+            freezer_journal_path(path, journal_path);
+            remove(journal_path);
+        } else {
+            errors += removed + added;
+        }
     }
-    fclose(fp); // 关闭文件
-    
-    calculate_freezer_status(f);  // 读取完成后重新计算冰柜状态并排序
-    sort_food_list(f);
+    freezer_unlock(lock);
+    if (saved) printf("%s: %d added, %d removed\n", name, added, removed);
+    else printf("%s: not saved, %d add(s) and %d remove(s) were not applied\n", name, added, removed);  // 文件没有改动，不能报告成已完成
+    return errors;
 }
 
-void show_maininterface() {  // 显示一级菜单
-    printf("\n=== Main Menu ===\n");
-    printf("Welcome to llwwds' freezer management system\n");
-    printf("\n");
+/*
+ * 函数：run_batch
+ * 功能：批处理模式：从文件或标准输入读取逗号分隔的命令，按冰柜分组执行，逐行报告错误
+ * 参数：source - 命令文件路径，"-" 表示标准输入
+ * 返回：全部成功返回0，有错误返回1（用作进程退出码）
+ */
+int run_batch(const char* source) {
+    FILE* fp = strcmp(source, "-") == 0 ? stdin : fopen(source, "r");
+    if (fp == NULL) {
+        printf("Error: Cannot open batch file %s\n", source);
+        return 1;
+    }
 
-    warehouse_number = 0;  // 重置仓库计数
-    int max_num = 0; // 用局部变量替代全局计数器
-    DIR *dir = opendir("data"); // 打开data目录，DIR为读取文件用的数据类型，若失败则返回NULL
-    if (dir!=NULL) {
-        for (struct dirent *temp = readdir(dir); temp != NULL; temp = readdir(dir)) {
-            struct stat st;  // 文件状态结构体
-            char path[600];  // 路径缓冲区
-            sprintf(path, "data/%s", temp->d_name);
-            
-            if (stat(path, &st) == 0 && S_ISDIR(st.st_mode) && strcmp(temp->d_name, ".") != 0 && strcmp(temp->d_name, "..") != 0) {
-                // 检查当前查看的文件是否 不为文件夹，不为当前文件，不为上一级文件 若满足条件则读它的编号
-                int num;
-                if (sscanf(temp->d_name, "warehouse_%d", &num) == 1 && num > max_num) {
-                    max_num = num;
-                }
-                printf("  [Warehouse] %s\n", temp->d_name); // 打印仓库名
+    batch_command* commands = NULL;
+    int count = 0, capacity = 0, errors = 0;
+    freezer_file_list freezers = {NULL, 0, 0};
+    char line[1024];
+    for (int line_no = 1; fgets(line, sizeof(line), fp) != NULL; line_no++) {
+        size_t len = strlen(line);
+        if (len == sizeof(line) - 1 && line[len - 1] != '\n') {  // 超长的行：报错并跳过剩余部分
+            printf("line %d: line too long\n", line_no);
+            errors++;
+            for (int ch = fgetc(fp); ch != '\n' && ch != EOF; ch = fgetc(fp));
+            continue;
+        }
+        if (count == capacity) {
+            int new_capacity = capacity ? capacity * 2 : 256;
+            batch_command* temp = (batch_command*)realloc(commands, (size_t)new_capacity * sizeof(batch_command));
+            if (temp == NULL) {
+                printf("line %d: out of memory\n", line_no);
+                errors++;
+                break;
             }
+            commands = temp;
+            capacity = new_capacity;
+        }
+        const char* error = NULL;
+        int result = batch_parse_line(line, &commands[count], &freezers, &error);
+        if (result == -1) {
+            printf("line %d: %s\n", line_no, error);
+            errors++;
+        } else if (result == 1) {
+            commands[count++].line = line_no;
         }
-        closedir(dir); // 关闭目录
-        warehouse_number = max_num; // 仅更新一次
     }
-    else{
-        printf("Error: Cannot open data directory\n");  // 若失败，则报错并返回
-        return;
+    if (fp != stdin) fclose(fp);
+
+    errors += place_batch_adds(commands, count, &freezers);
+    qsort(commands, count, sizeof(batch_command), batch_cmp);  // 没能选定冰柜的命令排在最前，跳过
+    int first = 0;
+    for (; first < count && commands[first].freezer == -1; first++);
+    frezzer f;
+    frezzer_init(&f);
+    for (int start = first, end; start < count; start = end) {
+        for (end = start; end < count && commands[end].freezer == commands[start].freezer; end++);
+        errors += batch_apply(&f, freezers.paths[commands[start].freezer], commands + start, end - start);
     }
+    frezzer_free(&f);
+    free(commands);
+    free(freezers.paths);
+    printf("Batch finished: %d command(s), %d error(s)\n", count, errors);
+    return errors > 0;
+}
 
-    printf("\n");  // 显示文件名之后，打印操作提示
-    printf("========== Main Menu ==========\n");
-    printf(" [0] Create Warehouse\n");
-    printf(" [1] Open Warehouse\n");
-    printf(" [2] Delete Warehouse\n");
-    printf(" [-1] Exit\n");
-    printf("===============================\n");
-    printf("Please enter a number to operate: ");
+void random_bench_food(food* item, int i) {  // 性能测试用：按编号生成一个随机食物
+    const char* types[] = {"Veg", "Meat", "Fruit"};
+    sprintf(item->food_name, "item%d", i);
+    strcpy(item->food_type, types[rand() % 3]);
+    item->food_volume = (int)((long long)rand() * FREZZER_CAPACITY / ((long long)RAND_MAX + 1));
+    item->food_temperature = rand() % FREZZER_TEMP_RANGE + FREZZER_TEMP_MIN;
 }
 
-void show_inside_warehoues(char* target_warehouse_path) {  // 显示二级菜单（仓库内的冰柜们），列出指定仓库内的所有冰柜 传入：仓库路径
-    printf("\n=== Warehouse: %s ===\n", target_warehouse_path);
-    struct stat temp;  // 存放文件夹的属性信息
-    if (stat(target_warehouse_path, &temp) != 0 || !S_ISDIR(temp.st_mode)) {  // 若无法打开，则报错并返回
-        printf("The warehouse does not exist.\n");
-        return;
+/*
+ * 函数：fill_random_freezer
+ * 功能：用固定种子生成n个随机食物放进冰柜，供性能测试使用
+ * 参数：f - 指向冰柜结构体的指针（需已初始化）
+ * 参数：n - 生成的食物数量
+ * 返回：成功返回1，内存不足返回0
+ */
+int fill_random_freezer(frezzer* f, int n) {
+    srand(12345);  // 固定种子，保证每次生成的数据一样
+    for (int i = 0; i < n; i++) {
+        food item;
+        random_bench_food(&item, i);
+        if (food_store_add(&f->store, &item) == -1) return 0;
     }
+    return 1;
+}
 
-    DIR *dir = opendir(target_warehouse_path); // 打开目标仓库的文件夹
-    int count = 0; // 变量：记录冰柜数量
-    if (dir) {
-        struct dirent *entry;  // 指向目录项的指针
-        for (entry = readdir(dir); entry != NULL; entry = readdir(dir)) {  // 遍历目标仓库的文件夹中的所有文件，直到下一个是null
-            struct stat temp;
-            char path[600];
-            sprintf(path, "%s/%s", target_warehouse_path, entry->d_name);  // 拼出完整的文件路径
-            if (stat(path, &temp) == 0 && S_ISREG(temp.st_mode)) {  // 判断文件是否存在，并检查是否为普通文件
-                char *dot = strrchr(entry->d_name, '.');  // 检查后缀名是否为 .txt，dot指向这个位置
-                if (dot && strcmp(dot, ".txt") == 0) {
-                    frezzer f;  // 新建一个冰柜变量
-                    load_freezer_from_file(path, &f);  // 初始化冰柜
-                    printf("  [Freezer] %s  Temperature: %d C  Available: %d / 100\n",entry->d_name, f.frezzer_temperature, f.frezzer_available_volume);
-                    count++;
-                }
-            }
-        }
-        closedir(dir);  // 关闭目标仓库的文件夹
+/*
+ * 函数：bench_sort
+ * 功能：对比旧排序（整条记录复制到临时数组 + qsort + 复制回去）与按键排序的耗时
+ * 参数：n - 食物数量
+ */
+void bench_sort(int n) {
+    // 1. 旧方法：完整的food数组，去掉了100的上限，其余与原来的sort_food_list一致
+    double legacy_ms = -1;
+    food* data = (food*)malloc((size_t)n * sizeof(food));
+    food* temp_data = (food*)malloc((size_t)n * sizeof(food));
+    if (data != NULL && temp_data != NULL) {
+        srand(12345);  // 与fill_random_freezer生成同样的数据
+        for (int i = 0; i < n; i++) random_bench_food(&data[i], i);
+        double start = now_ms();
+        for (int i = 0; i < n; i++) temp_data[i] = data[i];
+        qsort(temp_data, n, sizeof(food), cmp);
+        for (int i = 0; i < n; i++) data[i] = temp_data[i];
+        legacy_ms = now_ms() - start;
     }
-    else{
-        printf("Error: Cannot open warehouse directory\n");  // 若失败，则报错并返回
+    free(data);
+    free(temp_data);
+
+    // 2. 新方法：紧凑记录，按键排序
+    frezzer f;
+    frezzer_init(&f);
+    if (!fill_random_freezer(&f, n)) {
+        printf("Error: Out of memory for %d items\n", n);
+        frezzer_free(&f);
         return;
     }
-    if (count == 0) printf("  (Empty)\n"); // 如果没有冰柜，提示为空
+    double start = now_ms();
+    sort_food_list(&f);
+    double key_ms = now_ms() - start;
 
-    // 显示操作选项
-    printf("\n");
-    printf("Enter 0 to create a new freezer\n");
-    printf("Enter 1 to open a freezer\n");
-    printf("Enter 2 to delete a freezer\n");
-    printf("Enter -1 to return\n");
-    printf("Please enter a number to operate: ");
+    int sorted = 1;  // 检查结果确实是体积降序
+    for (int i = 1; i < f.store.count; i++) {
+        if (f.store.items[i - 1].volume < f.store.items[i].volume) sorted = 0;
+    }
+
+    printf("%-10d %-14.2f %-14.2f %-11.1f %s\n", n, legacy_ms, key_ms,
+           key_ms > 0 ? legacy_ms / key_ms : 0.0, sorted ? "ok" : "NOT SORTED");
+    frezzer_free(&f);
 }
 
-/*
- * 函数：show_freezer_content
- * 功能：显示三级菜单（食物列表），列出冰柜内的食物信息
- * 参数：f - 指向冰柜结构体的指针
- * 参数：freezer_name - 冰柜的名称
- */
-void show_freezer_content(frezzer* f, const char* freezer_name) {
-    printf("\n=== Freezer: %s ===\n", freezer_name);
-    calculate_freezer_status(f); // 确保显示前状态是最新的
-    printf("Temperature: %d C\n", f->frezzer_temperature);
-    printf("Available Volume: %d / 100\n", f->frezzer_available_volume);
-    printf("Food List (Sorted by Volume Desc):\n");
-    printf("%-20s %-10s %-10s %-10s\n", "Name", "Type", "Volume", "Temp");
-    printf("----------------------------------------------------\n");
-    
-    int idx = 0;          // 变量：食物序号
-    for (node* curr = f->head; curr != NULL; curr = curr->next) { // 遍历指针
-        printf("%d. %-17s %-10s %-10d %-10d\n", ++idx, curr->data.food_name, curr->data.food_type, curr->data.food_volume, curr->data.food_temperature);
-    }
+// 结构体：原来的链表节点，只在性能测试中用来对比逐个malloc的开销
+typedef struct legacy_node {
+    food data;
+    struct legacy_node* next;
+} legacy_node;
 
-    // Show options
-    printf("\n");
-    printf("========== Freezer Menu ==========\n");
-    printf(" [0] Add Food\n");
-    printf(" [1] Delete Food\n");
-    printf(" [2] Modify Food\n");
-    printf(" [3] Query Food\n");
-    printf(" [-1] Return\n");
-    printf("==================================\n");
-    printf("Please enter a number to operate: ");
+void fill_bench_food(food* item, int i) {  // 性能测试用：按编号填一个食物
+    sprintf(item->food_name, "item%d", i);
+    strcpy(item->food_type, "Veg");
+    item->food_volume = i % FREZZER_CAPACITY;
+    item->food_temperature = i % FREZZER_TEMP_RANGE + FREZZER_TEMP_MIN;
 }
 
 /*
- * 函数：remove_dir_recursive
- * 功能：递归删除目录及其包含的所有文件和子目录
- * 参数：path - 要删除的目录路径
+ * 函数：bench_alloc
+ * 功能：对比"加载n个食物再释放"的循环：原来的逐个malloc链表节点、每次新建容器、复用同一个冰柜的内存
+ * 参数：n - 每轮的食物数量
+ * 参数：cycles - 循环轮数
  */
-void remove_dir_recursive(const char *path) {
-    DIR *d = opendir(path); // 打开目录
-    size_t path_len = strlen(path);
-    struct dirent *p;
+void bench_alloc(int n, int cycles) {
+    // 1. 原来的做法：每个食物malloc一个节点，释放时逐个free
+    double start = now_ms();
+    for (int c = 0; c < cycles; c++) {
+        legacy_node *head = NULL, *tail = NULL;
+        for (int i = 0; i < n; i++) {
+            legacy_node* temp = (legacy_node*)malloc(sizeof(legacy_node));
+            if (temp == NULL) break;
+            fill_bench_food(&temp->data, i);
+            temp->next = NULL;
+            if (head == NULL) head = temp;
+            else tail->next = temp;
+            tail = temp;
+        }
+        for (legacy_node *temp = head, *next; temp != NULL; temp = next) {
+            next = temp->next;
+            free(temp);
+        }
+    }
+    double legacy_ms = (now_ms() - start) / cycles;
 
-    if (!d) return; // 打开失败直接返回
+    // 2. 每轮新建一个冰柜，用完整体释放
+    int fresh_allocations = 0;
+    start = now_ms();
+    for (int c = 0; c < cycles; c++) {
+        frezzer f;
+        frezzer_init(&f);
+        for (int i = 0; i < n; i++) {
+            food item;
+            fill_bench_food(&item, i);
+            if (food_store_add(&f.store, &item) == -1) break;
+        }
+        fresh_allocations = f.store.allocations;
+        frezzer_free(&f);
+    }
+    double fresh_ms = (now_ms() - start) / cycles;
 
-    for (p = readdir(d); p != NULL; p = readdir(d)) {
-        char *buf;
-        size_t len;
+    // 3. 复用同一个冰柜：每轮只清空，不释放
+    frezzer f;
+    frezzer_init(&f);
+    start = now_ms();
+    for (int c = 0; c < cycles; c++) {
+        frezzer_reset(&f);
+        for (int i = 0; i < n; i++) {
+            food item;
+            fill_bench_food(&item, i);
+            if (food_store_add(&f.store, &item) == -1) break;
+        }
+    }
+    double reuse_ms = (now_ms() - start) / cycles;
+    int reuse_allocations = f.store.allocations;
+    frezzer_free(&f);
 
-        // 跳过 . 和 ..
-        if (!strcmp(p->d_name, ".") || !strcmp(p->d_name, ".."))
-            continue;
+    printf("%-10d %-16.2f %-12d %-16.2f %-12d %-16.2f %d\n", n, legacy_ms, n, fresh_ms, fresh_allocations, reuse_ms, reuse_allocations);
+}
 
-        len = path_len + strlen(p->d_name) + 2;
-        buf = malloc(len); // 分配路径缓冲区内存
+/*
+ * 函数：generate_freezer_file
+ * 功能：生成一个合成的冰柜文本文件：食物的体积加起来不超过冰柜容量，温度在允许范围内，约十分之一的名称超过15字节
+ * 参数：path - 冰柜的文本文件路径
+ * 参数：n - 食物数量
+ * 返回：成功返回1，失败返回0
+ */
+int generate_freezer_file(const char* path, int n) {
+    static const char* types[] = {"Veg", "Meat", "Fruit", "Fish", "Dairy", "Bread", "IceCream", "Dumpling"};
+    FILE* fp = fopen(path, "w");
+    if (fp == NULL) return 0;
+    long long fill = (long long)rand() * (FREZZER_CAPACITY + 1LL) / ((long long)RAND_MAX + 1);  // 这个冰柜装了多满：按序号把fill分给n个食物，总和正好是fill
+    for (int i = 0; i < n; i++) {
+        int volume = (int)(fill * (i + 1) / n - fill * i / n);
+        if (i % 10 == 9) fprintf(fp, "frozen_dumpling_%d", rand());  // 长名称，放在溢出区
+        else fprintf(fp, "food%d", rand() % 100000);
+        fprintf(fp, " %s %d %d\n", types[rand() % 8], volume, rand() % FREZZER_TEMP_RANGE + FREZZER_TEMP_MIN);
+    }
+    return fclose(fp) == 0;
+}
 
-        if (buf) {
-            sprintf(buf, "%s/%s", path, p->d_name);
-            struct stat temp;
-            if (stat(buf, &temp) == 0) {
-                // 如果是目录则递归删除，否则直接删除文件
-                if (S_ISDIR(temp.st_mode))
-                    remove_dir_recursive(buf);
-                else
-                    remove(buf);
+/*
+ * 函数：generate_warehouses
+ * 功能：在 root 下生成 warehouse_1..warehouse_N，每个仓库 freezers 个冰柜，每个冰柜 items 个食物（固定种子，结果可重复）
+ * 参数：root - 根目录（通常是 data）
+ * 参数：warehouses - 仓库数量
+ * 参数：freezers - 每个仓库的冰柜数量
+ * 参数：items - 每个冰柜的食物数量
+ * 返回：成功返回1，失败返回0
+ */
+int generate_warehouses(const char* root, int warehouses, int freezers, int items) {
+    srand(12345);
+    _mkdir(root);  // 目录已存在时失败，忽略即可
+    for (int w = 1; w <= warehouses; w++) {
+        char path[600];
+        sprintf(path, "%s/warehouse_%d", root, w);
+        _mkdir(path);
+        for (int i = 1; i <= freezers; i++) {
+            sprintf(path, "%s/warehouse_%d/frezzer%d.txt", root, w, i);
+            if (!generate_freezer_file(path, items)) {
+                printf("Error: Cannot write %s\n", path);
+                return 0;
             }
-            free(buf); // 释放缓冲区
         }
     }
-    closedir(d); // 关闭目录
-    _rmdir(path); // 删除空目录本身
+    return 1;
+}
+
+void bench_report(const char* op, long long items, double ms) {  // 输出一行结果（CSV：操作,食物数,毫秒,每个食物纳秒）
+    printf("%s,%lld,%.3f,%.1f\n", op, items, ms, items > 0 ? ms * 1e6 / (double)items : 0.0);
+    fflush(stdout);
 }
 
 /*
- * Function: clear_buffer
- * Purpose: Clear the input buffer to prevent infinite loops on invalid input
+ * 函数：bench_suite
+ * 功能：性能测试套件：食物数从100起每次乘10直到 max_items，在 bench_data 下生成数据，
+ *       对读取、保存（文本和二进制）、排序、完整计算冰柜状态、按种类查询、仓库列表计时，结果以CSV写到标准输出
+ *       小规模重复多次取最快的一次，减少计时误差；跑完删掉 bench_data
+ * 参数：max_items - 最大的食物数
  */
-void clear_buffer() {
-    int c;
-    for (c = getchar(); c != '\n' && c != EOF; c = getchar());
+void bench_suite(int max_items) {
+    printf("op,items,ms,ns_per_item\n");
+    int saved_format = freezer_binary_format;
+    frezzer f;
+    frezzer_init(&f);
+    for (int n = 100; n > 0 && n <= max_items; n = n <= max_items / 10 ? n * 10 : -1) {
+        int repeat = n <= 100000 ? 5 : 1;
+        double best[12];  // 各项操作的最短耗时
+        for (int k = 0; k < 12; k++) best[k] = -1;
+        char warehouse_path[100], path[100];
+        _mkdir("bench_data");
+        strcpy(warehouse_path, "bench_data/warehouse_1");
+        _mkdir(warehouse_path);
+        sprintf(path, "%s/frezzer1.txt", warehouse_path);
+        srand(12345);
+        if (!generate_freezer_file(path, n)) {
+            printf("Error: Cannot write %s\n", path);
+            break;
+        }
+        int found = 0;  // 查询结果，防止被优化掉
+        for (int r = 0; r < repeat; r++) {
+            double t[9], start;
+            freezer_binary_format = 0;
+            start = now_ms(); load_freezer_from_file(path, &f); t[0] = now_ms() - start;  // 读文本
+            start = now_ms(); save_freezer_to_file(path, &f); t[1] = now_ms() - start;  // 写文本
+            freezer_binary_format = 1;
+            start = now_ms(); save_freezer_to_file(path, &f); t[2] = now_ms() - start;  // 写二进制（同时删掉文本文件）
+            start = now_ms(); load_freezer_from_file(path, &f); t[3] = now_ms() - start;  // 读二进制
+            start = now_ms(); calculate_freezer_status(&f); t[4] = now_ms() - start;
+            uint16_t type_id = food_type_find("Fish");
+            start = now_ms();
+            for (int i = food_store_find(&f.store, -1, type_id); i != -1; i = food_store_find(&f.store, i, type_id)) found++;
+            t[5] = now_ms() - start;
+            freezer_binary_format = 0;
+            save_freezer_to_file(path, &f);  // 换回文本，下一轮从文本读
+            frezzer_reset(&f);
+            fill_random_freezer(&f, n);  // 排序用乱序的数据
+            start = now_ms(); sort_food_list(&f); t[6] = now_ms() - start;
+            frezzer_reset(&f);
+            for (int k = 0; k < 7; k++) if (best[k] < 0 || t[k] < best[k]) best[k] = t[k];
+        }
+
+        // 仓库列表和列式快照：同样多的食物分到每个100个食物的冰柜里，先不带摘要缓存（快照），再带缓存（快照）
+        strcpy(warehouse_path, "bench_data/warehouse_2");
+        _mkdir(warehouse_path);
+        int freezer_count = n / 100 > 0 ? n / 100 : 1;
+        srand(12345);
+        for (int i = 1; i <= freezer_count; i++) {
+            sprintf(path, "%s/frezzer%d.txt", warehouse_path, i);
+            generate_freezer_file(path, n / freezer_count);
+        }
+        for (int r = 0; r < repeat; r++) {
+            summary_cache c;
+            sprintf(path, "%s/freezers.idx", warehouse_path);
+            remove(path);
+            double start = now_ms(); load_warehouse_summaries(warehouse_path, &c); double cold = now_ms() - start;
+            free(c.items);
+            start = now_ms(); load_warehouse_summaries(warehouse_path, &c); double warm = now_ms() - start;
+            free(c.items);
+            if (best[7] < 0 || cold < best[7]) best[7] = cold;
+            if (best[8] < 0 || warm < best[8]) best[8] = warm;
+
+            warehouse_snapshot snapshot;
+            int reloaded;
+            sprintf(path, "%s/warehouse.col", warehouse_path);
+            remove(path);
+            start = now_ms(); warehouse_snapshot_refresh(warehouse_path, &snapshot, &reloaded); cold = now_ms() - start;
+            snapshot_free(&snapshot);
+            start = now_ms(); warehouse_snapshot_refresh(warehouse_path, &snapshot, &reloaded); warm = now_ms() - start;
+            snapshot_free(&snapshot);
+            if (best[9] < 0 || cold < best[9]) best[9] = cold;
+            if (best[10] < 0 || warm < best[10]) best[10] = warm;
+        }
+        double start = now_ms();
+        remove_dir_recursive(warehouse_path);  // 删除仓库（当场删完，不走后台）
+        best[11] = now_ms() - start;
+        remove_dir_recursive("bench_data");
+
+        const char* names[] = {"load_text", "save_text", "save_binary", "load_binary", "calculate_status", "type_query", "sort", "list_cold", "list_cached",
+            "snapshot_cold", "snapshot_cached", "remove_warehouse"};
+        for (int k = 0; k < 12; k++) bench_report(names[k], n, best[k]);
+        if (found < 0) printf("%d\n", found);
+    }
+    frezzer_free(&f);
+    freezer_binary_format = saved_format;
 }
 
 // -------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 
-int main() {
+int main(int argc, char* argv[]) {
+    if (argc > 1 && strcmp(argv[1], "--bench-sort") == 0) {  // 命令行参数 --bench-sort：只跑排序性能测试
+        printf("%-10s %-14s %-14s %-11s %s\n", "Items", "Legacy(ms)", "KeySort(ms)", "Speedup(x)", "Check");
+        bench_sort(10000);
+        bench_sort(1000000);
+        return 0;
+    }
+    if (argc > 1 && strcmp(argv[1], "--bench") == 0) {  // 命令行参数 --bench [最大食物数]：性能测试套件，CSV输出
+        bench_suite(argc > 2 ? atoi(argv[2]) : 1000000);
+        return 0;
+    }
+    if (argc > 4 && strcmp(argv[1], "--generate") == 0) {  // 命令行参数 --generate 仓库数 冰柜数 食物数：在data下生成合成数据
+        return !generate_warehouses("data", atoi(argv[2]), atoi(argv[3]), atoi(argv[4]));
+    }
+    if (argc > 1 && strcmp(argv[1], "--bench-alloc") == 0) {  // 命令行参数 --bench-alloc：对比逐个malloc与整块内存的加载/释放开销（每轮平均）
+        printf("%-10s %-16s %-12s %-16s %-12s %-16s %s\n", "Items", "Malloc(ms)", "Mallocs", "Fresh(ms)", "Mallocs", "Reused(ms)", "Mallocs(total)");
+        bench_alloc(10000, 100);
+        bench_alloc(1000000, 5);
+        return 0;
+    }
+
+    const char* format = getenv("FREZZER_FORMAT");  // 环境变量 FREZZER_FORMAT=text：继续用文本格式保存冰柜
+    if (format != NULL && strcmp(format, "text") == 0) freezer_binary_format = 0;
+    const char* fsync_policy = getenv("FREZZER_FSYNC");  // 环境变量 FREZZER_FSYNC：日志的落盘策略
+    if (fsync_policy != NULL && strcmp(fsync_policy, "never") == 0) journal_fsync_policy = JOURNAL_FSYNC_NEVER;
+    if (fsync_policy != NULL && strcmp(fsync_policy, "always") == 0) journal_fsync_policy = JOURNAL_FSYNC_ALWAYS;
+    const char* stats = getenv("FREZZER_STATS");  // 环境变量 FREZZER_STATS=1：记录性能统计，退出时输出（菜单中也可随时查看）
+    if (stats != NULL && strcmp(stats, "1") == 0) {
+        stats_enabled = 1;
+        atexit(stats_dump);
+    }
+    const char* delete_policy = getenv("FREZZER_DELETE");  // 环境变量 FREZZER_DELETE=sync：删除仓库时当场删完再返回
+    if (delete_policy != NULL && strcmp(delete_policy, "sync") == 0) delete_in_background = 0;
+    const char* threads = getenv("FREZZER_THREADS");  // 环境变量 FREZZER_THREADS=n：并行时固定用n个线程（默认按CPU核数）
+    if (threads != NULL && atoi(threads) > 0) worker_threads = atoi(threads);
+    if (argc > 2 && strcmp(argv[1], "--report") == 0) {  // 命令行参数 --report 仓库编号：不进菜单，输出仓库报表
+        char path[600];
+        sprintf(path, "data/warehouse_%d", atoi(argv[2]));
+        warehouse_report(path);
+        return 0;
+    }
+    if (argc > 2 && strcmp(argv[1], "--batch") == 0) {  // 命令行参数 --batch 文件（- 为标准输入）：不进菜单，批量执行添加/删除
+        return run_batch(argv[2]);
+    }
+
     // 常量：定义菜单层级的状态码
     const int maininterface_menu = 1;  // 一级菜单：仓库管理
     const int inside_warehouse_menu = 2; // 二级菜单：冰柜管理
@@ -321,9 +4164,15 @@ int main() {
     char target_warehouse_path[600];  // 记录当前选中的仓库路径
     char target_freezer_path[600];    // 记录当前选中的冰柜文件路径
     char current_freezer_name[100];   // 记录当前选中的冰柜名称
+    int view_first = 0;  // 记录食物列表当前页第一行的下标
 
     frezzer current_frezzer; // 记录当前操作的冰柜
     frezzer_init(&current_frezzer); // 初始化冰柜
+    freezer_journal journal = {NULL, 0, 0, "", -1};  // 当前冰柜的修改日志
+    frezzer_init(&compaction.f);
+    frezzer_init(&recent_freezer.f);
+    reclaim_tombstones();  // 后台删除上次没删完的仓库
+    warehouse_model_start();  // 后台把仓库读进内存，之后菜单从内存显示
 
     for (;;) {  // 死循环：持续处理用户输入，直到用户选择退出
         if (current_menu == maininterface_menu) {
@@ -331,6 +4180,7 @@ int main() {
             scanf("%d", &choice); // 读取用户输入
 
             if (choice == -1) {  // 退出程序
+                freezer_compaction_wait();  // 等后台整理写完
                 return 0;
             } else if (choice == 0) {  // 创建新仓库
                 warehouse_number++;  // 更新仓库计数
@@ -347,7 +4197,7 @@ int main() {
                 if (scanf("%d", &temp) == 1) {
                     sprintf(target_warehouse_path, "data/warehouse_%d", temp);
                     struct stat temp;
-                    if (stat(target_warehouse_path, &temp) == 0 && S_ISDIR(temp.st_mode)) {
+                    if (stat_file(target_warehouse_path, &temp) == 0 && S_ISDIR(temp.st_mode)) {
                         current_menu = inside_warehouse_menu; // 切换到二级菜单
                     } else {
                         printf("Warehouse not found!\n");
@@ -361,8 +4211,24 @@ int main() {
                     char path[600];
                     sprintf(path, "data/warehouse_%d", temp);
                     printf("Deleting data/warehouse_%d...\n", temp);
-                    remove_dir_recursive(path); // 递归删除
+                    freezer_compaction_wait();  // 后台整理可能还在往这个仓库写文件
+                    delete_warehouse(path);  // 默认改名后在后台删除，菜单立刻返回
                 }
+            } else if (choice == 3) {  // 在所有仓库中查找食物
+                food_query q;
+                printf("\nType (* for any): "); scanf("%99s", q.type); clear_buffer();
+                if (strcmp(q.type, "*") == 0) q.type[0] = '\0';
+                printf("Name prefix (* for any): "); scanf("%99s", q.name_prefix); clear_buffer();
+                if (strcmp(q.name_prefix, "*") == 0) q.name_prefix[0] = '\0';
+                printf("Volume range (min max): ");
+                if (scanf("%d %d", &q.volume_min, &q.volume_max) != 2) { q.volume_min = -2147483647 - 1; q.volume_max = 2147483647; }  // 输入无效时不限
+                clear_buffer();
+                printf("Temperature range (min max): ");
+                if (scanf("%d %d", &q.temperature_min, &q.temperature_max) != 2) { q.temperature_min = -2147483647 - 1; q.temperature_max = 2147483647; }
+                clear_buffer();
+                query_all_warehouses(&q);
+            } else if (choice == 4) {  // 显示性能统计
+                stats_dump();
             }
         } 
         // === 二级菜单逻辑 ===
@@ -381,13 +4247,24 @@ int main() {
                 if (scanf("%d", &num) == 1) {
                     clear_buffer();
                     char path[600];
-                    sprintf(path, "%s/frezzer%d.txt", target_warehouse_path, num);
-                    FILE* fp = fopen(path, "w");
-                    if (fp) {
-                        fclose(fp);
-                        printf("Freezer created: frezzer%d\n", num);
-                    } else {
+                    int len = snprintf(path, sizeof(path), "%s/frezzer%d.txt", target_warehouse_path, num);
+                    if (len < 0 || (size_t)len >= sizeof(path)) {  // 路径太长，放不下
                         printf("Failed to create freezer.\n");
+                    } else {
+                        char journal_path[610];
+                        freezer_compaction_wait();
+                        int lock = freezer_lock(path);
+                        freezer_journal_path(path, journal_path);
+                        remove(journal_path);  // 同名冰柜留下的旧日志不能用在新冰柜上
+                        frezzer empty;  // 按当前的保存格式写一个空冰柜
+                        frezzer_init(&empty);
+                        save_freezer_to_file(path, &empty);
+                        freezer_unlock(lock);
+                        if (freezer_exists(path)) {
+                            printf("Freezer created: frezzer%d\n", num);
+                        } else {
+                            printf("Failed to create freezer.\n");
+                        }
                     }
                 } else {
                     clear_buffer();
@@ -397,11 +4274,18 @@ int main() {
                 printf("\nEnter freezer name to open (without .txt): ");  // 提示用户输入冰柜名称
                 char name[100];
                 scanf("%s", name);
-                sprintf(target_freezer_path, "%s/%s.txt", target_warehouse_path, name);
-                struct stat temp;
-                if (stat(target_freezer_path, &temp) == 0) {
+                int len = snprintf(target_freezer_path, sizeof(target_freezer_path), "%s/%s.txt", target_warehouse_path, name);
+                if (len >= 0 && (size_t)len < sizeof(target_freezer_path) && freezer_exists(target_freezer_path)) {  // 文本文件或二进制文件都可以；路径太长时当作没有
                     strcpy(current_freezer_name, name);
-                    load_freezer_from_file(target_freezer_path, &current_frezzer); // 读取数据
+                    view_first = 0;  // 从第一页（体积最大的食物）开始显示
+                    freezer_compaction_wait();  // 这个冰柜可能正在后台整理
+                    int lock = freezer_lock(target_freezer_path);  // 读取和打开日志之间不能有别的进程写入，日志记下的版本才对得上
+                    int records = freezer_cache_take(target_freezer_path, &current_frezzer);  // 刚关闭过且没变的冰柜不用重新读取
+                    if (records == -1) records = load_freezer_from_file(target_freezer_path, &current_frezzer); // 读取数据（基础文件 + 日志）
+                    if (!journal_open(&journal, target_freezer_path, records)) {
+                        printf("Warning: Cannot open journal, changes will be saved on return.\n");
+                    }
+                    freezer_unlock(lock);
                     current_menu = inside_frezzer_menu; // 切换到三级菜单
                 } else {
                     printf("Freezer not found.\n");
@@ -412,25 +4296,82 @@ int main() {
                 if (scanf("%d", &num) == 1) {
                     clear_buffer();
                     char path[600];
-                    sprintf(path, "%s/frezzer%d.txt", target_warehouse_path, num);
-                    if (remove(path) == 0) printf("Deleted: frezzer%d\n", num);
-                    else printf("Delete failed.\n");
+                    int len = snprintf(path, sizeof(path), "%s/frezzer%d.txt", target_warehouse_path, num);
+                    if (len < 0 || (size_t)len >= sizeof(path)) {  // 路径太长，放不下
+                        printf("Delete failed.\n");
+                    } else {
+                        char binary_path[610], journal_path[610];
+                        freezer_binary_path(path, binary_path);
+                        freezer_journal_path(path, journal_path);
+                        freezer_compaction_wait();
+                        int lock = freezer_lock(path);
+                        remove(journal_path);
+                        int removed = (remove(path) == 0) + (remove(binary_path) == 0);  // 两种格式的文件都要删掉
+                        freezer_unlock(lock);
+                        if (removed > 0) printf("Deleted: frezzer%d\n", num);
+                        else printf("Delete failed.\n");
+                    }
                 } else {
                     clear_buffer();
                     printf("Invalid number.\n");
                 }
+            } else if (choice == 3) {  // 自动放入：由放置算法挑一个放得下的冰柜
+                batch_command c;  // 当作批处理中冰柜名写 * 的一条添加命令
+                c.line = 1;
+                c.op = 'A';
+                c.freezer = -1;
+                sscanf(target_warehouse_path, "data/warehouse_%d", &c.warehouse);
+                printf("\nEnter Name: "); scanf("%99s", c.item.food_name); clear_buffer();
+                printf("Enter Type (Veg/Meat/Fruit): "); scanf("%99s", c.item.food_type); clear_buffer();
+                printf("Enter Volume: "); if(scanf("%d", &c.item.food_volume)!=1) c.item.food_volume=0; clear_buffer();
+                printf("Enter Temp: "); if(scanf("%d", &c.item.food_temperature)!=1) c.item.food_temperature=0; clear_buffer();
+                if (c.item.food_volume < 0 || c.item.food_volume > FREZZER_CAPACITY) {
+                    printf("Error: Volume must be from 0 to %d.\n", FREZZER_CAPACITY);
+                } else if (c.item.food_temperature < FREZZER_TEMP_MIN || c.item.food_temperature > FREZZER_TEMP_MAX) {
+                    printf("Error: Invalid temperature.\n");
+                } else {
+                    freezer_file_list freezers = {NULL, 0, 0};
+                    if (place_batch_adds(&c, 1, &freezers) == 0) {
+                        frezzer f;
+                        frezzer_init(&f);
+                        batch_apply(&f, freezers.paths[c.freezer], &c, 1);
+                        frezzer_free(&f);
+                    }
+                    free(freezers.paths);
+                }
+            } else if (choice == 4) {  // 仓库报表：在列式快照上汇总，只重新读取改动过的冰柜
+                warehouse_report(target_warehouse_path);
             }
         }
         // === 三级菜单逻辑 ===
         else if (current_menu == inside_frezzer_menu) {
-            show_freezer_content(&current_frezzer, current_freezer_name); // 显示三级菜单
-            for (choice = scanf("%d", &choice); choice != 1; choice = scanf("%d", &choice)) {
+            view_first = freezer_page_start(&current_frezzer, view_first);  // 删除食物后当前页可能已越过末尾
+            show_freezer_content(&current_frezzer, current_freezer_name, view_first); // 显示三级菜单（只显示当前页）
+            for (; scanf("%d", &choice) != 1; ) {  // 读到数字为止（不能把scanf的返回值赋给choice，否则选项总是1）
                 clear_buffer();
-             }
+            }
 
-            if (choice == -1) {  // 返回上一级并保存数据
-                save_freezer_to_file(target_freezer_path, &current_frezzer);
-                free_list(current_frezzer.head); // 释放内存
+            if (choice == -1) {  // 返回上一级：修改已经记在日志里，日志比冰柜本身还长时才交给后台整理成新的基础文件
+                int lock = freezer_lock(target_freezer_path);
+                if (journal.active) {
+                    journal_close(&journal, target_freezer_path);
+                    freezer_unlock(lock);
+                    if (journal.records >= current_frezzer.store.count + 16) freezer_compaction_start(target_freezer_path, &current_frezzer, &journal);
+                    else freezer_cache_put(target_freezer_path, &current_frezzer, &journal);  // 留在内存中，马上再打开时不用重读
+                } else if (journal_changed(&journal, target_freezer_path) || current_frezzer.load_errors > 0) {  // 不记日志又被别的进程改过，或文件有读不懂的行：不覆盖原文件，另存一份
+                    char conflict_path[610];
+                    strcpy(conflict_path, target_freezer_path);
+                    strcpy(strrchr(conflict_path, '.'), ".conflict");
+                    if (save_freezer_to_text(conflict_path, &current_frezzer)) {
+                        printf("Error: Freezer %s, your version was saved to %s\n",
+                               current_frezzer.load_errors > 0 ? "has unreadable rows" : "was changed by another session", conflict_path);
+                    }
+                    freezer_unlock(lock);
+                } else {
+                    save_freezer_to_file(target_freezer_path, &current_frezzer);  // 不记日志时整体保存
+                    freezer_unlock(lock);
+                }
+                frezzer_reset(&current_frezzer); // 清空冰柜，内存留给下一次打开的冰柜复用
                 current_menu = inside_warehouse_menu; // 返回二级菜单
             } else if (choice == 0) {  // 添加食物
                 food new_food;
@@ -439,102 +4380,95 @@ int main() {
                 printf("Enter Volume: "); if(scanf("%d", &new_food.food_volume)!=1) new_food.food_volume=0; clear_buffer();  // 提示用户输入食物体积
                 printf("Enter Temp: "); if(scanf("%d", &new_food.food_temperature)!=1) new_food.food_temperature=0; clear_buffer();  // 提示用户输入食物温度
 
-                // 检查约束条件
-                calculate_freezer_status(&current_frezzer); // 更新当前状态
-                
-                // 1. 体积检查
-                if (new_food.food_volume > current_frezzer.frezzer_available_volume) {
+                // 检查约束条件（先合并别的进程的修改，冰柜状态随每次修改增量更新，已是最新）
+                int lock = freezer_edit_begin(&journal, target_freezer_path, &current_frezzer);
+
+                // 1. 体积检查（负体积读取时会被当成坏行，不能写进冰柜）
+                if (new_food.food_volume < 0) {
+                    printf("Error: Volume must be from 0 to %d.\n", FREZZER_CAPACITY);
+                } else if (new_food.food_volume > current_frezzer.frezzer_available_volume) {
                     printf("Error: Not enough space! Available: %d, Needed: %d\n", 
                            current_frezzer.frezzer_available_volume, new_food.food_volume);
-                    continue;
                 }
-
                 // 2. 温度检查
-                if (new_food.food_temperature < -20) {
-                    printf("Error: Temperature too low! Min allowed is -20.\n");
-                    continue;
+                else if (new_food.food_temperature < FREZZER_TEMP_MIN) {
+                    printf("Error: Temperature too low! Min allowed is %d.\n", FREZZER_TEMP_MIN);
+                } else if (new_food.food_temperature > FREZZER_TEMP_MAX) {
+                     printf("Error: Temperature too high! Max allowed is %d.\n", FREZZER_TEMP_MAX);
                 }
-                if (new_food.food_temperature > 10) {
-                     printf("Error: Temperature too high! Max allowed is 10.\n");
-                     continue;
+                // 按体积顺序插入容器并更新冰柜状态，不用整体重新排序
+                else if (!frezzer_add_food(&current_frezzer, &new_food)) {
+                    printf("Error: Out of memory!\n");
+                } else {
+                    journal_append(&journal, target_freezer_path, 'A', &new_food, NULL);
+                    printf("Food added.\n");
                 }
-
-                // 添加到链表
-                node* new_node = create_node(&(current_frezzer.head), &(current_frezzer.tail));
-                new_node->data = new_food;
-                printf("Food added.\n");
-                
-                // 重新计算并排序
-                calculate_freezer_status(&current_frezzer);
-                sort_food_list(&current_frezzer);
+                freezer_unlock(lock);
 
             } else if (choice == 1) {  // 删除食物
-                printf("\nEnter index to delete: ");  // 提示用户输入要删除的食物序号
-                int idx;
-                if(scanf("%d", &idx)!=1) idx=-1; clear_buffer();
-                if (idx < 1) continue;
-
-                int count = 1;
-                // 寻找指定序号的节点
-                int found_idx = 0;
-                for (node *curr = current_frezzer.head, *prev = NULL; curr != NULL; prev = curr, curr = curr->next, count++) {
-                   if (count == idx) {
-                        if (prev == NULL) { // 删除的是头节点
-                            current_frezzer.head = curr->next;
-                            if (current_frezzer.head == NULL) current_frezzer.tail = NULL;
-                        } else {
-                            prev->next = curr->next;
-                            if (prev->next == NULL) current_frezzer.tail = prev;
-                        }
-                        free(curr); // 释放节点内存
+                printf("\nEnter index or name to delete: ");  // 提示用户输入要删除的食物序号或名称
+                char key[100];
+                scanf("%99s", key); clear_buffer();
+
+                int slot = food_store_lookup(&current_frezzer.store, key);  // 序号走排序树，名称走名称索引
+                if (slot != -1) {
+                    food old_food;  // 日志按内容记下删掉的是哪一个
+                    food_store_get(&current_frezzer.store, slot, &old_food);
+                    int lock = freezer_edit_begin(&journal, target_freezer_path, &current_frezzer);
+                    slot = journal_find(&current_frezzer, &old_food);  // 重新读取过时槽位会变，按内容再找一次
+                    if (slot == -1) {
+                        printf("Error: %s was changed by another session, nothing deleted.\n", old_food.food_name);
+                    } else {
+                        frezzer_remove_food(&current_frezzer, slot);
+                        journal_append(&journal, target_freezer_path, 'D', &old_food, NULL);
                         printf("Deleted.\n");
-                        calculate_freezer_status(&current_frezzer);
-                        found_idx = 1;
-                        break;
-                   }
-                }
-                if (!found_idx) {
-                    printf("Invalid index.\n");
+                    }
+                    freezer_unlock(lock);
+                } else {
+                    printf("Invalid index or name.\n");
                 }
             } else if (choice == 2) {  // 修改食物
-                printf("\nEnter index to modify: ");  // 提示用户输入要修改的食物序号
-                int idx;
-                if(scanf("%d", &idx)!=1) idx=-1; clear_buffer();
+                printf("\nEnter index or name to modify: ");  // 提示用户输入要修改的食物序号或名称
+                char key[100];
+                scanf("%99s", key); clear_buffer();
                 
-                int count = 1;
-                int found_idx = 0;
-                for (node* curr = current_frezzer.head; curr != NULL; curr = curr->next, count++) {
-                    if (count == idx) {
-                        food temp_food = curr->data;
-                        printf("Modifying %s. Enter new details.\n", temp_food.food_name);
-                        
-                        printf("\nNew Name: "); scanf("%s", temp_food.food_name); clear_buffer();  // 提示用户输入新的食物名称
-                        printf("New Type: "); scanf("%s", temp_food.food_type); clear_buffer();  // 提示用户输入新的食物类型
-                        printf("New Volume: "); if(scanf("%d", &temp_food.food_volume)!=1) temp_food.food_volume=0; clear_buffer();  // 提示用户输入新的食物体积
-                        printf("New Temp: "); if(scanf("%d", &temp_food.food_temperature)!=1) temp_food.food_temperature=0; clear_buffer();  // 提示用户输入新的食物温度
-                        
-                        // 验证修改后的约束条件
-                        int current_used = 100 - current_frezzer.frezzer_available_volume;
-                        int other_used = current_used - curr->data.food_volume;
-                        int new_avail = 100 - other_used;
-                        
-                        if (temp_food.food_volume > new_avail) {
-                            printf("Error: Not enough space for modification.\n");
-                        } else if (temp_food.food_temperature < -20 || temp_food.food_temperature > 10) {
-                            printf("Error: Invalid temperature.\n");
-                        } else {
-                            curr->data = temp_food; // 更新数据
-                            printf("Modified.\n");
-                            calculate_freezer_status(&current_frezzer);
-                            sort_food_list(&current_frezzer);
-                        }
-                        found_idx = 1;
-                        break;
+                int slot = food_store_lookup(&current_frezzer.store, key);
+                if (slot != -1) {
+                    food old_food, temp_food;
+                    food_store_get(&current_frezzer.store, slot, &old_food);
+                    temp_food = old_food;
+                    int old_volume = old_food.food_volume;
+                    printf("Modifying %s. Enter new details.\n", temp_food.food_name);
+                    
+                    printf("\nNew Name: "); scanf("%s", temp_food.food_name); clear_buffer();  // 提示用户输入新的食物名称
+                    printf("New Type: "); scanf("%s", temp_food.food_type); clear_buffer();  // 提示用户输入新的食物类型
+                    printf("New Volume: "); if(scanf("%d", &temp_food.food_volume)!=1) temp_food.food_volume=0; clear_buffer();  // 提示用户输入新的食物体积
+                    printf("New Temp: "); if(scanf("%d", &temp_food.food_temperature)!=1) temp_food.food_temperature=0; clear_buffer();  // 提示用户输入新的食物温度
+                    
+                    // 验证修改后的约束条件（先合并别的进程的修改，要修改的食物可能已经不在了）
+                    int lock = freezer_edit_begin(&journal, target_freezer_path, &current_frezzer);
+                    slot = journal_find(&current_frezzer, &old_food);
+                    int current_used = FREZZER_CAPACITY - current_frezzer.frezzer_available_volume;
+                    int other_used = current_used - old_volume;
+                    int new_avail = FREZZER_CAPACITY - other_used;
+                    
+                    if (slot == -1) {
+                        printf("Error: %s was changed by another session, nothing modified.\n", old_food.food_name);
+                    } else if (temp_food.food_volume < 0) {
+                        printf("Error: Volume must be from 0 to %d.\n", FREZZER_CAPACITY);
+                    } else if (temp_food.food_volume > new_avail) {
+                        printf("Error: Not enough space for modification.\n");
+                    } else if (temp_food.food_temperature < FREZZER_TEMP_MIN || temp_food.food_temperature > FREZZER_TEMP_MAX) {
+                        printf("Error: Invalid temperature.\n");
+                    } else if (!frezzer_update_food(&current_frezzer, slot, &temp_food)) { // 更新数据并挪到新的位置
+                        printf("Error: Out of memory!\n");
+                    } else {
+                        journal_append(&journal, target_freezer_path, 'M', &old_food, &temp_food);
+                        printf("Modified.\n");
                     }
-                }
-                
-                if (!found_idx) {
-                    printf("Invalid index.\n");
+                    freezer_unlock(lock);
+                } else {
+                    printf("Invalid index or name.\n");
                 }
             } else if (choice == 3) {  // 查询特定种类的食物
                 printf("\nEnter food type to query: ");  // 提示用户输入要查询的食物类型
@@ -542,15 +4476,43 @@ int main() {
                 scanf("%s", q_type); clear_buffer();
                 printf("\nMatches for '%s':\n", q_type);
                 int found = 0;
-                for (node* curr = current_frezzer.head; curr != NULL; curr = curr->next) {
-                    if (strcmp(curr->data.food_type, q_type) == 0) {
-                         printf("  %s (Vol: %d, Temp: %d)\n", curr->data.food_name, curr->data.food_volume, curr->data.food_temperature);
-                         found = 1;
-                    }
+                double start = stats_start();
+                uint16_t type_id = food_type_find(q_type);  // 先换成种类编号，之后都是整数比较
+                for (int i = food_store_find(&current_frezzer.store, -1, type_id); i != -1; i = food_store_find(&current_frezzer.store, i, type_id)) {
+                    const food_record* curr = &current_frezzer.store.items[i];
+                    printf("  %s (Vol: %d, Temp: %d)\n", food_record_name(&current_frezzer.store, curr), curr->volume, curr->temperature);
+                    found = 1;
                 }
                 if (!found) printf("  None found.\n");
+                stats_stop(STATS_TIMER_QUERY, start);
                 printf("\nPress 1 to continue...");
                 int dummy; scanf("%d", &dummy);
+            } else if (choice == 4) {  // 导出为文本文件，放在 export 目录下，不会被当成冰柜读取
+                char export_path[800];
+                const char* warehouse_name = strrchr(target_warehouse_path, '/');
+                warehouse_name = warehouse_name ? warehouse_name + 1 : target_warehouse_path;
+                _mkdir("export");  // 目录已存在时失败，忽略即可
+                sprintf(export_path, "export/%s_%s.txt", warehouse_name, current_freezer_name);
+                if (save_freezer_to_text(export_path, &current_frezzer)) printf("Exported to %s\n", export_path);
+            } else if (choice == 5) {  // 下一页
+                if (view_first + freezer_page_size < current_frezzer.store.count) view_first += freezer_page_size;
+            } else if (choice == 6) {  // 上一页
+                view_first = view_first > freezer_page_size ? view_first - freezer_page_size : 0;
+            } else if (choice == 7) {  // 跳到指定序号的食物，从它开始显示一页
+                printf("\nEnter item number: ");
+                int number;
+                if (scanf("%d", &number) == 1 && number >= 1) view_first = number - 1;
+                clear_buffer();
+            } else if (choice == 8) {  // 只看体积最大的N个：每页N行，回到第一页
+                printf("\nEnter N (1-500): ");
+                int n;
+                if (scanf("%d", &n) == 1 && n >= 1 && n <= 500) {
+                    freezer_page_size = n;
+                    view_first = 0;
+                } else {
+                    printf("Invalid number.\n");
+                }
+                clear_buffer();
             }
         }
     }
@@ -0,0 +1,96 @@
+﻿// 回归测试的公共部分：每个测试程序先包含 frezzer_c.c（main 已改名），再包含本文件
+// 提供 CHECK 计数、在临时目录中运行，以及几个比较冰柜内容的工具函数
+
+int check_total = 0;  // 全局变量：检查的总数
+int check_failed = 0;  // 全局变量：失败的检查数
+char check_dir[] = "/tmp/frezzer_check.XXXXXX";  // 全局变量：本次测试的临时目录
+
+#define CHECK(cond) check_result((cond) != 0, #cond, __FILE__, __LINE__)
+
+int check_result(int ok, const char* text, const char* file, int line) {  // 记录一次检查的结果，失败时打印位置和条件，返回ok
+    check_total++;
+    if (!ok) {
+        check_failed++;
+        printf("FAIL %s:%d: %s\n", file, line, text);
+    }
+    return ok;
+}
+
+int check_begin() {  // 建好临时目录并进入，测试不碰当前目录下的 data；成功返回1
+    if (mkdtemp(check_dir) == NULL || chdir(check_dir) != 0) {
+        printf("Error: Cannot create a temporary directory\n");
+        return 0;
+    }
+    return 1;
+}
+
+int check_end(const char* name) {  // 删掉临时目录并报告结果，返回进程的退出码
+    if (chdir("/") == 0) remove_dir_recursive(check_dir);
+    if (check_failed > 0) {
+        printf("%s: %d of %d checks failed\n", name, check_failed, check_total);
+        return 1;
+    }
+    printf("%s: all %d checks passed\n", name, check_total);
+    return 0;
+}
+
+int food_order_cmp(const void* a, const void* b) {  // 比较两个食物的全部字段，得到与读取顺序无关的固定顺序
+    const food *x = a, *y = b;
+    if (x->food_volume != y->food_volume) return y->food_volume - x->food_volume;
+    if (x->food_temperature != y->food_temperature) return x->food_temperature - y->food_temperature;
+    int c = strcmp(x->food_name, y->food_name);
+    return c != 0 ? c : strcmp(x->food_type, y->food_type);
+}
+
+/*
+ * 函数：freezer_foods
+ * 功能：按显示顺序取出冰柜中的所有食物，顺带检查显示顺序确实是体积降序
+ * 参数：f - 冰柜
+ * 参数：count - 输出食物数量
+ * 返回：按固定顺序排好的食物数组（用完由调用者释放），内存不足返回NULL
+ */
+food* freezer_foods(const frezzer* f, int* count) {
+    food* items = (food*)malloc((size_t)(f->store.count + 1) * sizeof(food));
+    int n = 0;
+    if (items == NULL) return NULL;
+    for (int i = f->store.first; i != -1 && n <= f->store.count; i = f->store.links[i].next) {
+        food_store_get(&f->store, i, &items[n]);
+        if (n > 0) CHECK(items[n - 1].food_volume >= items[n].food_volume);
+        n++;
+    }
+    CHECK(n == f->store.count);
+    qsort(items, n, sizeof(food), food_order_cmp);
+    *count = n;
+    return items;
+}
+
+int freezer_same(const frezzer* a, const frezzer* b) {  // 两个冰柜的食物（不论读取顺序）和冰柜状态是否完全一样
+    int na, nb;
+    food* x = freezer_foods(a, &na);
+    food* y = freezer_foods(b, &nb);
+    int same = x != NULL && y != NULL && na == nb
+        && a->frezzer_available_volume == b->frezzer_available_volume && a->frezzer_temperature == b->frezzer_temperature;
+    for (int i = 0; same && i < na; i++) same = food_order_cmp(&x[i], &y[i]) == 0;
+    free(x);
+    free(y);
+    return same;
+}
+
+int status_consistent(frezzer* f) {  // 增量维护的冰柜状态与完整重算的结果是否一致
+    int volume = f->frezzer_available_volume, temperature = f->frezzer_temperature;
+    calculate_freezer_status(f);
+    return volume == f->frezzer_available_volume && temperature == f->frezzer_temperature;
+}
+
+void sample_freezer(frezzer* f) {  // 测试用的冰柜：几种种类，有长名称（放在溢出区）、体积相同的食物和边界温度
+    const char* types[] = {"Veg", "Meat", "Fruit", "IceCream"};
+    for (int i = 0; i < 12; i++) {
+        food item;
+        if (i % 4 == 3) sprintf(item.food_name, "a_rather_long_food_name_%d", i);
+        else sprintf(item.food_name, "food%d", i);
+        strcpy(item.food_type, types[i % 4]);
+        item.food_volume = i % 3 * (FREZZER_CAPACITY / 40);
+        item.food_temperature = i % 2 ? FREZZER_TEMP_MIN : FREZZER_TEMP_MAX - i % 5;
+        frezzer_add_food(f, &item);
+    }
+}
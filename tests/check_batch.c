@@ -0,0 +1,154 @@
+﻿// 批处理的回归测试：命令的解析，以及冰柜名写 * 时的自动选择冰柜（首次适应递减）
+#define main frezzer_main  // 程序自己的 main 改名，用下面测试的 main
+#include "../frezzer_c.c"
+#undef main
+#include "check.h"
+
+int parse_batch(const char* text, batch_command* c) {  // 解析一行批处理命令，返回 batch_parse_line 的结果
+    char line[400];
+    const char* error = NULL;
+    freezer_file_list freezers = {NULL, 0, 0};
+    strcpy(line, text);
+    int result = batch_parse_line(line, c, &freezers, &error);
+    if (result == -1) CHECK(error != NULL);
+    free(freezers.paths);
+    return result;
+}
+
+void test_batch_parse() {  // 批处理命令：合法的命令、空行和注释，以及各种必须拒绝的写法
+    batch_command c;
+    char line[400];
+    CHECK(parse_batch("add,1,frezzer1,milk,Dairy,5,-5", &c) == 1 && c.op == 'A' && c.freezer == 0 && c.item.food_volume == 5);
+    CHECK(parse_batch(" add , 2 , * , milk , Dairy , 0 , -5 ", &c) == 1 && c.freezer == -1 && c.warehouse == 2);
+    CHECK(parse_batch("remove,3,frezzer2,milk", &c) == 1 && c.op == 'D' && strcmp(c.item.food_name, "milk") == 0);
+    CHECK(parse_batch("", &c) == 0);
+    CHECK(parse_batch("# comment", &c) == 0);
+    CHECK(parse_batch("op,warehouse,freezer,name,type,volume,temp", &c) == 0);
+
+    const char* rejected[] = {
+        "add,1,frezzer1,milk,Dairy,5",  // 少一个字段
+        "add,1,frezzer1,milk,Dairy,5,-5,extra",  // 多一个字段
+        "remove,1,frezzer1",
+        "move,1,frezzer1,milk",  // 不认识的命令
+        "add,one,frezzer1,milk,Dairy,5,-5",  // 仓库不是数字
+        "add,1,../frezzer1,milk,Dairy,5,-5",  // 冰柜名带路径
+        "add,1,,milk,Dairy,5,-5",
+        "remove,1,*,milk",  // 删除必须指明冰柜
+        "add,1,frezzer1,,Dairy,5,-5",  // 空名称
+        "add,1,frezzer1,milk,,5,-5",  // 空种类
+        "add,1,frezzer1,milk,Dairy,-1,-5",  // 负体积
+        "add,1,frezzer1,milk,Dairy,5.5,-5",  // 体积不是整数
+        "add,1,frezzer1,milk,Dairy,5,",  // 没有温度
+        "add,1,frezzer1,milk,Dairy,5,99999999999",  // 超出int范围
+    };
+    for (size_t i = 0; i < sizeof(rejected) / sizeof(rejected[0]); i++) {
+        int result = parse_batch(rejected[i], &c);
+        if (result != -1) printf("  accepted: %s\n", rejected[i]);
+        CHECK(result == -1);
+    }
+    sprintf(line, "add,1,frezzer1,milk,Dairy,%d,-5", FREZZER_CAPACITY + 1);  // 超过冰柜容量
+    CHECK(parse_batch(line, &c) == -1);
+    sprintf(line, "add,1,frezzer1,milk,Dairy,5,%d", FREZZER_TEMP_MIN - 1);  // 低于温度范围
+    CHECK(parse_batch(line, &c) == -1);
+    sprintf(line, "add,1,frezzer1,milk,Dairy,5,%d", FREZZER_TEMP_MAX + 1);  // 高于温度范围
+    CHECK(parse_batch(line, &c) == -1);
+    strcpy(line, "add,1,frezzer1,");  // 名称超过99个字符
+    for (int i = 0; i < 100; i++) strcat(line, "x");
+    strcat(line, ",Dairy,5,-5");
+    CHECK(parse_batch(line, &c) == -1);
+}
+
+void make_freezer(const char* path, int used) {  // 建一个已用容积为used的冰柜文件
+    frezzer f;
+    frezzer_init(&f);
+    food item = {"old", "Veg", used, FREZZER_TEMP_MAX};
+    if (used > 0) frezzer_add_food(&f, &item);
+    CHECK(save_freezer_to_file(path, &f));
+    frezzer_free(&f);
+}
+
+void place_add(batch_command* c, int line, int warehouse, int freezer, int volume) {  // 填一条添加命令
+    memset(c, 0, sizeof(*c));
+    c->line = line;
+    c->warehouse = warehouse;
+    c->freezer = freezer;
+    c->op = 'A';
+    sprintf(c->item.food_name, "item%d", line);
+    strcpy(c->item.food_type, "Veg");
+    c->item.food_volume = volume;
+    c->item.food_temperature = FREZZER_TEMP_MIN;
+}
+
+void test_batch_place() {  // 自动选择冰柜：与逐个顺序查找的首次适应递减结果相同，不超出任何冰柜的容量，放不下的报告出来不执行
+    const int used[3] = {FREZZER_CAPACITY * 7 / 10, FREZZER_CAPACITY / 10, 0};
+    const int volumes[] = {95, 60, 35, 30, 25, 20, 5, 5, 0};  // 按容量的百分比
+    const int n = (int)(sizeof(volumes) / sizeof(volumes[0]));
+    _mkdir("data");
+    _mkdir("data/warehouse_1");
+    char path[100];
+    for (int i = 0; i < 3; i++) {
+        sprintf(path, "data/warehouse_%d/frezzer%d.txt", 1, i + 1);
+        make_freezer(path, used[i]);
+    }
+
+    freezer_file_list freezers = {NULL, 0, 0};
+    batch_command c[16];
+    CHECK(freezer_file_list_add(&freezers, "data/warehouse_1/frezzer2.txt"));
+    place_add(&c[0], 1, 1, 0, FREZZER_CAPACITY / 2);  // 同一批中直接指定冰柜的添加先占地方
+    for (int i = 0; i < n; i++) place_add(&c[i + 1], i + 2, 1, -1, FREZZER_CAPACITY * volumes[i] / 100);
+    place_add(&c[n + 1], n + 2, 9, -1, 1);  // 没有这个仓库
+    int errors = place_batch_adds(c, n + 2, &freezers);
+
+    int available[3];  // 逐个按顺序查找的首次适应递减，与线段树的结果对照
+    int expected_errors = 1;
+    for (int k = 0; k < 3; k++) available[k] = FREZZER_CAPACITY - used[k];
+    available[1] -= FREZZER_CAPACITY / 2;
+    for (int i = 0; i < n + 2; i++) {
+        if (c[i].warehouse != 1 || c[i].line == 1) continue;
+        int k = 0;
+        for (; k < 3 && available[k] < c[i].item.food_volume; k++);
+        if (k == 3) {
+            expected_errors++;
+            CHECK(c[i].freezer == -1);
+            continue;
+        }
+        available[k] -= c[i].item.food_volume;
+        sprintf(path, "data/warehouse_1/frezzer%d.txt", k + 1);
+        CHECK(c[i].freezer >= 0 && c[i].freezer < freezers.count && strcmp(freezers.paths[c[i].freezer], path) == 0);
+    }
+    CHECK(errors == expected_errors);
+    CHECK(expected_errors > 1);  // 这组数据里确实有放不下的
+    for (int k = 0; k < 3; k++) CHECK(available[k] >= 0);
+    for (int i = 0; i < n + 2; i++) {
+        if (c[i].warehouse == 9) CHECK(c[i].freezer == -1);
+    }
+    free(freezers.paths);
+
+    FILE* fp = fopen("place.csv", "w");  // 整个批处理走一遍：放不下的和温度超出范围的不执行，执行后各冰柜的剩余容积与上面对照的结果相同
+    if (!CHECK(fp != NULL)) return;
+    fprintf(fp, "add,1,frezzer2,explicit,Veg,%d,%d\n", FREZZER_CAPACITY / 2, FREZZER_TEMP_MIN);
+    for (int i = 0; i < n; i++) fprintf(fp, "add,1,*,item%d,Veg,%d,%d\n", i, FREZZER_CAPACITY * volumes[i] / 100, FREZZER_TEMP_MIN);
+    fprintf(fp, "add,1,*,too_cold,Veg,1,%d\n", FREZZER_TEMP_MIN - 1);
+    fclose(fp);
+    CHECK(run_batch("place.csv") == 1);
+    frezzer f;
+    frezzer_init(&f);
+    int count = 0;
+    for (int i = 0; i < 3; i++) {
+        sprintf(path, "data/warehouse_1/frezzer%d.txt", i + 1);
+        load_freezer_from_file(path, &f);
+        CHECK(f.frezzer_available_volume == available[i]);  // 与上面对照的结果相同
+        CHECK(f.frezzer_temperature >= FREZZER_TEMP_MIN && f.frezzer_temperature <= FREZZER_TEMP_MAX);
+        CHECK(food_store_find_name(&f.store, -1, "too_cold") == -1);
+        count += f.store.count - (used[i] > 0);
+    }
+    CHECK(count == n + 2 - expected_errors);
+    frezzer_free(&f);
+}
+
+int main() {
+    if (!check_begin()) return 1;
+    test_batch_parse();
+    test_batch_place();
+    return check_end("check_batch");
+}
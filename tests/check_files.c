@@ -0,0 +1,180 @@
+﻿// 冰柜文件的回归测试：生成器、文本和二进制格式（版本1到3）的保存与读取、日志重放
+#define main frezzer_main  // 程序自己的 main 改名，用下面测试的 main
+#include "../frezzer_c.c"
+#undef main
+#include "check.h"
+
+int files_equal(const char* a, const char* b) {  // 两个文件的内容是否完全一样
+    FILE* x = fopen(a, "rb");
+    FILE* y = fopen(b, "rb");
+    int same = x != NULL && y != NULL;
+    for (; same; ) {
+        int c = fgetc(x);
+        same = c == fgetc(y);
+        if (c == EOF) break;
+    }
+    if (x != NULL) fclose(x);
+    if (y != NULL) fclose(y);
+    return same;
+}
+
+void test_generator() {  // 生成器：结果可重复，生成的冰柜都能完整读入，状态在容量和温度范围之内
+    CHECK(generate_warehouses("gen_a", 2, 3, 40));
+    CHECK(generate_warehouses("gen_b", 2, 3, 40));
+    CHECK(files_equal("gen_a/warehouse_2/frezzer3.txt", "gen_b/warehouse_2/frezzer3.txt"));
+    frezzer f;
+    frezzer_init(&f);
+    for (int w = 1; w <= 2; w++) {
+        for (int i = 1; i <= 3; i++) {
+            char path[100];
+            sprintf(path, "gen_a/warehouse_%d/frezzer%d.txt", w, i);
+            load_freezer_from_file(path, &f);
+            CHECK(f.store.count == 40);
+            CHECK(f.load_errors == 0);
+            CHECK(f.frezzer_available_volume >= 0 && f.frezzer_available_volume <= FREZZER_CAPACITY);
+            CHECK(f.frezzer_temperature >= FREZZER_TEMP_MIN && f.frezzer_temperature <= FREZZER_TEMP_MAX);
+            CHECK(status_consistent(&f));
+        }
+    }
+    frezzer_free(&f);
+}
+
+void test_text_round_trip() {  // 文本格式：写出再读入后内容不变；读不懂的行不会在保存时丢掉
+    frezzer f, g;
+    frezzer_init(&f);
+    frezzer_init(&g);
+    sample_freezer(&f);
+    CHECK(save_freezer_to_text("round.txt", &f));
+    load_freezer_from_text("round.txt", &g);
+    CHECK(freezer_same(&f, &g));
+    CHECK(g.load_errors == 0);
+
+    FILE* fp = fopen("round.txt", "a");  // 追加一行坏数据：读入时跳过，但文件不能再被整体重写
+    if (fp != NULL) {
+        fputs("broken row\n", fp);
+        fclose(fp);
+    }
+    load_freezer_from_text("round.txt", &g);
+    CHECK(g.load_errors == 1);
+    CHECK(g.store.count == f.store.count);
+    CHECK(!save_freezer_to_file("round.txt", &g));
+    frezzer_free(&f);
+    frezzer_free(&g);
+}
+
+void test_binary_round_trip() {  // 二进制格式：当前版本写出再读入，以及手工构造的版本1、版本2文件都能读出同样的冰柜
+    frezzer f, g;
+    frezzer_init(&f);
+    frezzer_init(&g);
+    sample_freezer(&f);
+    CHECK(save_freezer_to_binary("round.frz", &f));
+    CHECK(load_freezer_from_binary("round.frz", &g));
+    CHECK(freezer_same(&f, &g));
+    CHECK(status_consistent(&g));
+
+    FILE* fp = fopen("round.frz", "rb");  // 版本2：与版本3相同，只是文件头少了最后的容量和温度范围
+    char image[65536];
+    size_t size = fp != NULL ? fread(image, 1, sizeof(image), fp) : 0;
+    if (fp != NULL) fclose(fp);
+    CHECK(size > sizeof(freezer_file_header) && size < sizeof(image));
+    ((freezer_file_header*)image)->version = 2;
+    fp = fopen("v2.frz", "wb");
+    if (fp != NULL) {
+        fwrite(image, 1, FREEZER_HEADER_V2_SIZE, fp);
+        fwrite(image + sizeof(freezer_file_header), 1, size - sizeof(freezer_file_header), fp);
+        fclose(fp);
+    }
+    CHECK(load_freezer_from_binary("v2.frz", &g));
+    CHECK(freezer_same(&f, &g));
+
+    freezer_file_header h;  // 版本1：文件头只到温度直方图，后面是按显示顺序排好的完整food记录
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, "FRZB", 4);
+    h.version = 1;
+    h.record_size = sizeof(food);
+    h.count = (uint32_t)f.store.count;
+    h.available_volume = f.frezzer_available_volume;
+    h.temperature = f.frezzer_temperature;
+    h.temp_below_range = f.temp_below_range;
+    if (FREZZER_TEMP_RANGE == 31) memcpy(h.temp_histogram, f.temp_histogram, sizeof(h.temp_histogram));
+    fp = fopen("v1.frz", "wb");
+    if (fp != NULL) {
+        fwrite(&h, 1, FREEZER_HEADER_V1_SIZE, fp);
+        for (int i = f.store.first; i != -1; i = f.store.links[i].next) {
+            food item;
+            memset(&item, 0, sizeof(item));
+            food_store_get(&f.store, i, &item);
+            fwrite(&item, sizeof(item), 1, fp);
+        }
+        fclose(fp);
+    }
+    CHECK(load_freezer_from_binary("v1.frz", &g));
+    CHECK(freezer_same(&f, &g));
+
+    image[8] ^= 1;  // 损坏的文件（记录长度不对）必须被拒绝
+    fp = fopen("bad.frz", "wb");
+    if (fp != NULL) {
+        fwrite(image, 1, size, fp);
+        fclose(fp);
+    }
+    CHECK(!load_freezer_from_binary("bad.frz", &g));
+
+    frezzer_reset(&f);  // 空冰柜
+    CHECK(save_freezer_to_binary("empty.frz", &f));
+    CHECK(load_freezer_from_binary("empty.frz", &g));
+    CHECK(g.store.count == 0 && g.frezzer_available_volume == FREZZER_CAPACITY);
+    frezzer_free(&f);
+    frezzer_free(&g);
+}
+
+void test_journal_replay() {  // 日志：修改后没有整理就退出（模拟崩溃，最后半条记录没写完），重新读取时重放；基础文件被替换后旧日志不再重放
+    frezzer f, g;
+    frezzer_init(&f);
+    frezzer_init(&g);
+    sample_freezer(&f);
+    CHECK(save_freezer_to_file("journal.txt", &f));
+
+    freezer_journal j;
+    CHECK(journal_open(&j, "journal.txt", 0));
+    food item, changed;
+    strcpy(item.food_name, "added_after_save");
+    strcpy(item.food_type, "Fish");
+    item.food_volume = 1;
+    item.food_temperature = FREZZER_TEMP_MIN;
+    CHECK(frezzer_add_food(&f, &item));
+    CHECK(journal_append(&j, "journal.txt", 'A', &item, NULL));
+    int slot = food_store_find_name(&f.store, -1, "food1");
+    CHECK(slot != -1);
+    food_store_get(&f.store, slot, &item);
+    frezzer_remove_food(&f, slot);
+    CHECK(journal_append(&j, "journal.txt", 'D', &item, NULL));
+    slot = food_store_find_name(&f.store, -1, "food2");
+    CHECK(slot != -1);
+    food_store_get(&f.store, slot, &item);
+    changed = item;
+    changed.food_volume = 0;
+    strcpy(changed.food_type, "Dairy");
+    CHECK(frezzer_update_food(&f, slot, &changed));
+    CHECK(journal_append(&j, "journal.txt", 'M', &item, &changed));
+    fputs("A torn_record Veg 1", j.fp);  // 崩溃时写了一半的记录
+    fclose(j.fp);
+
+    CHECK(load_freezer_from_file("journal.txt", &g) == 3);
+    CHECK(freezer_same(&f, &g));
+    CHECK(status_consistent(&g));
+
+    CHECK(save_freezer_to_file("journal.txt", &f));  // 整理：替换基础文件，留下的旧日志对不上，不能再重放一遍
+    CHECK(load_freezer_from_file("journal.txt", &g) == 0);
+    CHECK(freezer_same(&f, &g));
+    frezzer_free(&f);
+    frezzer_free(&g);
+}
+
+int main() {
+    if (!check_begin()) return 1;
+    test_generator();
+    test_text_round_trip();
+    test_binary_round_trip();
+    test_journal_replay();
+    return check_end("check_files");
+}
@@ -0,0 +1,194 @@
+﻿// 食物容器的回归测试：随机混合添加、删除、修改、批量读入和整体重排，每次修改后核对排序树、显示顺序、按下标定位、内容、种类和名称索引，以及增量维护的容积、最低温度和温度直方图
+#define main frezzer_main  // 程序自己的 main 改名，用下面测试的 main
+#include "../frezzer_c.c"
+#undef main
+#include "check.h"
+
+#define STORE_OPS 4000  // 随机操作的次数
+#define STORE_MAX 300  // 食物超过这个数量时多删少加
+
+food shadow[STORE_MAX + 64];  // 全局变量：另存一份食物（不论顺序），与容器对照
+int shadow_count = 0;  // 全局变量：shadow 中的食物数量
+
+void random_food(food* item) {  // 随机生成一个食物：名称和种类从小范围里取，保证有重名、同种类和体积相同的食物，约四分之一是长名称；温度会略超出允许范围（像未校验的文件那样）
+    const char* types[] = {"Veg", "Meat", "Fruit", "Fish", "IceCream"};
+    int k = rand() % 40;
+    if (k % 4 == 3) sprintf(item->food_name, "long_name_for_the_spill_area_%d", k);
+    else sprintf(item->food_name, "food%d", k);
+    strcpy(item->food_type, types[rand() % 5]);
+    item->food_volume = rand() % 8;
+    item->food_temperature = rand() % (FREZZER_TEMP_RANGE + 4) + FREZZER_TEMP_MIN - 2;
+}
+
+void shadow_remove(const food* item) {  // 从 shadow 中去掉一个内容相同的食物
+    for (int i = 0; i < shadow_count; i++) {
+        if (food_order_cmp(&shadow[i], item) == 0) {
+            shadow[i] = shadow[--shadow_count];
+            return;
+        }
+    }
+    CHECK(!"removed food is not in the shadow copy");
+}
+
+/*
+ * 函数：check_tree
+ * 功能：中序遍历排序树：核对子树大小和优先级的堆性质，并把槽位按顺序记下
+ * 参数：s - 食物容器
+ * 参数：t - 子树的根
+ * 参数：order - 输出中序遍历的槽位
+ * 参数：n - order 中已有的槽位数
+ * 返回：子树的节点数
+ */
+int check_tree(const food_store* s, int t, int* order, int* n) {
+    if (t == -1) return 0;
+    const order_link* x = &s->links[t];
+    if (x->left != -1) CHECK(s->links[x->left].prio <= x->prio);
+    if (x->right != -1) CHECK(s->links[x->right].prio <= x->prio);
+    int size = check_tree(s, x->left, order, n);
+    if (*n < s->count) order[*n] = t;
+    (*n)++;
+    size += 1 + check_tree(s, x->right, order, n);
+    CHECK(x->size == size);
+    return size;
+}
+
+void check_order(const frezzer* f) {  // 显示链表、排序树和按下标定位三者一致，且按体积降序、体积相同时先插入的在前
+    const food_store* s = &f->store;
+    int* order = (int*)malloc((size_t)(s->count + 1) * sizeof(int));
+    if (!CHECK(order != NULL)) return;
+    int n = 0;
+    CHECK(check_tree(s, s->root, order, &n) == s->count);
+    int i = 0, prev = -1;
+    for (int slot = s->first; slot != -1 && i <= s->count; slot = s->links[slot].next, i++) {
+        CHECK(food_store_live(s, slot));
+        CHECK(s->links[slot].prev == prev);
+        if (prev != -1) CHECK(order_less(s, prev, slot));
+        if (i < n) CHECK(order[i] == slot);
+        CHECK(food_store_slot_at(s, i) == slot);
+        prev = slot;
+    }
+    CHECK(i == s->count);
+    CHECK(food_store_slot_at(s, s->count) == -1 && food_store_slot_at(s, -1) == -1);
+    free(order);
+}
+
+void check_contents(const frezzer* f) {  // 容器中的食物与 shadow 完全一样
+    int n;
+    food* items = freezer_foods(f, &n);
+    if (!CHECK(items != NULL)) return;
+    qsort(shadow, shadow_count, sizeof(food), food_order_cmp);
+    int same = n == shadow_count;
+    for (int i = 0; same && i < n; i++) same = food_order_cmp(&items[i], &shadow[i]) == 0;
+    CHECK(same);
+    free(items);
+}
+
+void check_index(const frezzer* f) {  // 每个食物都能沿种类索引和名称索引找到，且索引找到的个数与 shadow 中同种类、同名的个数相同
+    const food_store* s = &f->store;
+    for (int slot = s->first; slot != -1; slot = s->links[slot].next) {
+        food item;
+        food_store_get(s, slot, &item);
+        int same_type = 0, same_name = 0;
+        for (int i = 0; i < shadow_count; i++) {
+            same_type += strcmp(shadow[i].food_type, item.food_type) == 0;
+            same_name += strcmp(shadow[i].food_name, item.food_name) == 0;
+        }
+        int found = 0, n = 0;
+        uint16_t type_id = food_type_find(item.food_type);
+        CHECK(type_id != FOOD_TYPE_NONE);
+        for (int i = food_store_find(s, -1, type_id); i != -1 && n <= s->count; i = food_store_find(s, i, type_id), n++) {
+            CHECK(food_store_live(s, i));
+            found |= i == slot;
+        }
+        CHECK(found && n == same_type);
+        found = n = 0;
+        for (int i = food_store_find_name(s, -1, item.food_name); i != -1 && n <= s->count; i = food_store_find_name(s, i, item.food_name), n++) {
+            CHECK(food_store_live(s, i));
+            found |= i == slot;
+        }
+        CHECK(found && n == same_name);
+    }
+    CHECK(food_store_find_name(s, -1, "no_such_food") == -1);
+}
+
+void check_status(frezzer* f) {  // 增量维护的剩余容积、最低温度和温度直方图与按 shadow 算出的一致，也与完整重算的一致
+    int used = 0, min_temp = FREZZER_TEMP_MAX, below = 0;
+    int histogram[FREZZER_TEMP_RANGE] = {0};
+    for (int i = 0; i < shadow_count; i++) {
+        int t = shadow[i].food_temperature;
+        used += shadow[i].food_volume;
+        if (t < min_temp) min_temp = t;
+        if (t < FREZZER_TEMP_MIN) below++;
+        else if (t <= FREZZER_TEMP_MAX) histogram[t - FREZZER_TEMP_MIN]++;
+    }
+    CHECK(f->frezzer_available_volume == FREZZER_CAPACITY - used);
+    CHECK(f->frezzer_temperature == min_temp);
+    CHECK(f->temp_below_range == below);
+    CHECK(memcmp(f->temp_histogram, histogram, sizeof(histogram)) == 0);
+    CHECK(status_consistent(f));
+    CHECK(memcmp(f->temp_histogram, histogram, sizeof(histogram)) == 0 && f->temp_below_range == below);
+}
+
+void check_store(frezzer* f) {  // 每次修改之后的全部核对
+    check_order(f);
+    check_contents(f);
+    check_index(f);
+    check_status(f);
+}
+
+void test_random_operations() {  // 随机混合操作：逐个添加、删除、修改（走排序树的插入、摘除和重新定位），以及批量读入和整体重排（走 order_build）
+    frezzer f;
+    frezzer_init(&f);
+    srand(2024);
+    for (int op = 0; op < STORE_OPS; op++) {
+        int r = rand() % 20;
+        food item, old;
+        if (shadow_count == 0 || (r < 8 && shadow_count < STORE_MAX)) {  // 添加
+            random_food(&item);
+            CHECK(frezzer_add_food(&f, &item));
+            shadow[shadow_count++] = item;
+        } else if (r < 14) {  // 按显示下标删除
+            int slot = food_store_slot_at(&f.store, rand() % f.store.count);
+            if (!CHECK(slot != -1)) break;
+            food_store_get(&f.store, slot, &old);
+            frezzer_remove_food(&f, slot);
+            shadow_remove(&old);
+        } else if (r < 18) {  // 修改：有时只改名称或温度（体积不变也要重新定位）
+            int slot = food_store_slot_at(&f.store, rand() % f.store.count);
+            if (!CHECK(slot != -1)) break;
+            food_store_get(&f.store, slot, &old);
+            random_food(&item);
+            if (r == 17) item.food_volume = old.food_volume;
+            CHECK(frezzer_update_food(&f, slot, &item));
+            shadow_remove(&old);
+            shadow[shadow_count++] = item;
+        } else if (r == 18) {  // 整体重排：删除留下的空槽先被压掉
+            sort_food_list(&f);
+        } else {  // 像读取文件那样批量追加后排序一次
+            frezzer_reset(&f);
+            CHECK(food_store_reserve(&f.store, shadow_count));
+            for (int i = 0; i < shadow_count; i++) {
+                CHECK(food_store_add(&f.store, &shadow[i]) != -1);
+                frezzer_account(&f, shadow[i].food_volume, shadow[i].food_temperature, 1);
+            }
+            sort_food_list(&f);
+        }
+        check_store(&f);
+    }
+    for (; f.store.count > 0; ) {  // 全部删光
+        food old;
+        int slot = food_store_slot_at(&f.store, 0);
+        food_store_get(&f.store, slot, &old);
+        frezzer_remove_food(&f, slot);
+        shadow_remove(&old);
+    }
+    check_store(&f);
+    CHECK(f.store.first == -1 && f.store.root == -1);
+    frezzer_free(&f);
+}
+
+int main() {
+    if (!check_begin()) return 1;
+    test_random_operations();
+    return check_end("check_store");
+}
@@ -0,0 +1,297 @@
+﻿// 仓库级操作的回归测试：并行查询所有仓库、列式快照的增量更新、删除仓库
+#define main frezzer_main  // 程序自己的 main 改名，用下面测试的 main
+#include "../frezzer_c.c"
+#undef main
+#include "check.h"
+
+#define QUERY_WAREHOUSES 3  // 查询测试的仓库数
+#define QUERY_FREEZERS 5  // 每个仓库的冰柜数
+#define QUERY_ITEMS 300  // 每个冰柜的食物数
+
+int capture_begin(const char* path) {  // 把标准输出转到文件，返回原来的标准输出，失败返回-1
+    fflush(stdout);
+    int saved = dup(1);
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (saved == -1 || fd == -1 || dup2(fd, 1) == -1) {
+        if (fd != -1) close(fd);
+        if (saved != -1) close(saved);
+        return -1;
+    }
+    close(fd);
+    return saved;
+}
+
+void capture_end(int saved) {  // 恢复标准输出
+    fflush(stdout);
+    dup2(saved, 1);
+    close(saved);
+}
+
+/*
+ * 函数：query_expected
+ * 功能：不用线程，按冰柜列表的顺序逐个读取冰柜并按显示顺序筛选，写出与 query_all_warehouses 相同格式的结果行
+ * 参数：q - 筛选条件
+ * 参数：out - 结果文件
+ * 参数：files - 输出冰柜文件数
+ * 返回：匹配的食物数
+ */
+int query_expected(const food_query* q, const char* out, int* files) {
+    freezer_file_list list = {NULL, 0, 0};
+    collect_all_freezers(&list);
+    FILE* fp = fopen(out, "w");
+    frezzer f;
+    frezzer_init(&f);
+    int total = 0;
+    for (int i = 0; fp != NULL && i < list.count; i++) {
+        load_freezer_from_file(list.paths[i], &f);
+        char* name = list.paths[i] + 5;  // 去掉 data/ 和扩展名
+        *strrchr(name, '.') = '\0';
+        for (int slot = f.store.first; slot != -1; slot = f.store.links[slot].next) {
+            food item;
+            food_store_get(&f.store, slot, &item);
+            if (q->type[0] != '\0' && strcmp(item.food_type, q->type) != 0) continue;
+            if (strncmp(item.food_name, q->name_prefix, strlen(q->name_prefix)) != 0) continue;
+            if (item.food_volume < q->volume_min || item.food_volume > q->volume_max) continue;
+            if (item.food_temperature < q->temperature_min || item.food_temperature > q->temperature_max) continue;
+            fprintf(fp, "%-28s %-17s %-10s %-10d %-10d\n", name, item.food_name, item.food_type, item.food_volume, item.food_temperature);
+            total++;
+        }
+    }
+    if (fp != NULL) fclose(fp);
+    frezzer_free(&f);
+    *files = list.count;
+    free(list.paths);
+    return total;
+}
+
+int read_rows(const char* path, char rows[][160], int max, char* summary) {  // 读出文件中的结果行（以仓库名开头的行），统计行放进summary，返回行数，超过max行返回-1
+    FILE* fp = fopen(path, "r");
+    char line[400];
+    int n = 0;
+    if (fp == NULL) return -1;
+    for (; fgets(line, sizeof(line), fp) != NULL; ) {
+        if (summary != NULL && strstr(line, " match(es) in ") != NULL) strcpy(summary, line);
+        if (strncmp(line, "warehouse_", 10) != 0) continue;  // 表头、空行和统计行
+        if (n == max || strlen(line) >= 160) {
+            n = -1;
+            break;
+        }
+        strcpy(rows[n++], line);
+    }
+    fclose(fp);
+    return n;
+}
+
+int row_cmp(const void* a, const void* b) {
+    return strcmp((const char*)a, (const char*)b);
+}
+
+/*
+ * 函数：query_same
+ * 功能：查询输出与逐个读取的结果是否一致：冰柜的先后顺序和每个冰柜的结果数相同，每个冰柜的结果相同
+ *       （同一个冰柜中的先后不作要求：指定种类时沿种类索引找，不是显示顺序），统计行中的匹配数和冰柜文件数也相同
+ */
+int query_same(const char* actual, const char* expected, int total, int files) {
+    static char a[QUERY_WAREHOUSES * QUERY_FREEZERS * QUERY_ITEMS][160], e[QUERY_WAREHOUSES * QUERY_FREEZERS * QUERY_ITEMS][160];
+    char summary[400] = "";
+    int n = read_rows(actual, a, QUERY_WAREHOUSES * QUERY_FREEZERS * QUERY_ITEMS, summary);
+    int same = n == total && read_rows(expected, e, total, NULL) == total;
+    for (int i = 0; same && i < n; i++) same = strncmp(a[i], e[i], 28) == 0;  // 冰柜名占前28列
+    qsort(a, (size_t)(same ? n : 0), sizeof(a[0]), row_cmp);
+    qsort(e, (size_t)(same ? n : 0), sizeof(e[0]), row_cmp);
+    for (int i = 0; same && i < n; i++) same = strcmp(a[i], e[i]) == 0;
+    int matches = -1, file_count = -1;
+    return same && sscanf(summary, "%d match(es) in %d", &matches, &file_count) == 2 && matches == total && file_count == files;
+}
+
+void test_query() {  // 并行查询：合并后的结果与逐个读取的结果相同，冰柜文件数相同；线程数从1到多于冰柜数都试一遍
+    CHECK(generate_warehouses("data", QUERY_WAREHOUSES, QUERY_FREEZERS, QUERY_ITEMS));
+    frezzer f;  // 把一个冰柜存成二进制：同一个冰柜的 .txt 和 .frz 只能算一次
+    frezzer_init(&f);
+    load_freezer_from_file("data/warehouse_2/frezzer3.txt", &f);
+    CHECK(save_freezer_to_file("data/warehouse_2/frezzer3.txt", &f));
+    frezzer_free(&f);
+
+    food_query queries[4] = {
+        {"Meat", "", 0, FREZZER_CAPACITY, FREZZER_TEMP_MIN, FREZZER_TEMP_MAX},
+        {"", "food1", 0, 2, -10, 0},
+        {"", "", -2147483647 - 1, 2147483647, -2147483647 - 1, 2147483647},
+        {"NoSuchType", "", 0, FREZZER_CAPACITY, FREZZER_TEMP_MIN, FREZZER_TEMP_MAX},
+    };
+    const int threads[3] = {1, 4, QUERY_WAREHOUSES * QUERY_FREEZERS + 3};
+    for (int i = 0; i < 4; i++) {
+        int files;
+        int total = query_expected(&queries[i], "expected.out", &files);
+        CHECK(files == QUERY_WAREHOUSES * QUERY_FREEZERS);
+        if (i < 3) CHECK(total > 0);
+        for (int k = 0; k < 3; k++) {
+            worker_threads = threads[k];
+            int saved = capture_begin("query.out");
+            if (!CHECK(saved != -1)) continue;
+            query_all_warehouses(&queries[i]);
+            capture_end(saved);
+            CHECK(query_same("query.out", "expected.out", total, files));
+        }
+    }
+    worker_threads = 0;
+    remove_dir_recursive("data");
+}
+
+int snapshot_same(const warehouse_snapshot* a, const warehouse_snapshot* b) {  // 两个快照的冰柜表和各列是否完全相同
+    if (a->freezer_count != b->freezer_count || a->item_count != b->item_count) return 0;
+    for (int i = 0; i < a->freezer_count; i++) {
+        const snapshot_freezer *x = &a->freezers[i], *y = &b->freezers[i];
+        if (strcmp(x->summary.file_name, y->summary.file_name) != 0 || x->summary.mtime != y->summary.mtime || x->summary.size != y->summary.size
+            || x->summary.temperature != y->summary.temperature || x->summary.available_volume != y->summary.available_volume
+            || x->first != y->first || x->count != y->count) return 0;
+    }
+    for (int i = 0; i < a->item_count; i++) {
+        if (a->volume[i] != b->volume[i] || a->temperature[i] != b->temperature[i] || a->type_id[i] != b->type_id[i]
+            || strcmp(a->names + a->name_offset[i], b->names + b->name_offset[i]) != 0) return 0;
+    }
+    return 1;
+}
+
+int snapshot_matches_files(const char* warehouse_path, const warehouse_snapshot* s) {  // 快照中每个冰柜的食物与直接读取冰柜文件得到的相同（按显示顺序）
+    frezzer f;
+    frezzer_init(&f);
+    int same = 1;
+    for (int i = 0; same && i < s->freezer_count; i++) {
+        char path[600], text_path[600];
+        freezer_entry_paths(warehouse_path, s->freezers[i].summary.file_name, path, text_path);
+        load_freezer_from_file(text_path, &f);
+        same = f.store.count == s->freezers[i].count && f.frezzer_available_volume == s->freezers[i].summary.available_volume;
+        int k = s->freezers[i].first;
+        for (int slot = f.store.first; same && slot != -1; slot = f.store.links[slot].next, k++) {
+            food item;
+            food_store_get(&f.store, slot, &item);
+            same = s->volume[k] == item.food_volume && s->temperature[k] == item.food_temperature
+                && s->type_id[k] == food_type_find(item.food_type) && strcmp(s->names + s->name_offset[k], item.food_name) == 0;
+        }
+    }
+    frezzer_free(&f);
+    return same;
+}
+
+void test_snapshot() {  // 列式快照：改两个冰柜、加一个、删一个之后，增量更新只重读改过和新加的冰柜，结果与删掉快照文件后从头建的相同
+    warehouse_snapshot cold, warm, again;
+    int reloaded;
+    CHECK(generate_warehouses("data", 1, 6, 200));
+    worker_threads = 3;
+    CHECK(warehouse_snapshot_refresh("data/warehouse_1", &cold, &reloaded) && reloaded == 6);
+    CHECK(snapshot_matches_files("data/warehouse_1", &cold));
+    CHECK(warehouse_snapshot_refresh("data/warehouse_1", &again, &reloaded) && reloaded == 0);  // 什么都没变：全部沿用
+    CHECK(snapshot_same(&cold, &again));
+    snapshot_free(&cold);
+    snapshot_free(&again);
+
+    frezzer f;  // 改一个冰柜并存成二进制（文件名也变了）
+    frezzer_init(&f);
+    load_freezer_from_file("data/warehouse_1/frezzer2.txt", &f);
+    frezzer_remove_food(&f, food_store_slot_at(&f.store, 0));
+    food item = {"fresh_fish", "Fish", 0, FREZZER_TEMP_MIN};
+    CHECK(frezzer_add_food(&f, &item));
+    CHECK(save_freezer_to_file("data/warehouse_1/frezzer2.txt", &f));
+    load_freezer_from_file("data/warehouse_1/frezzer3.txt", &f);  // 再改一个，仍存成文本：文件名不变，只有修改时间和大小变了
+    CHECK(frezzer_add_food(&f, &item));
+    freezer_binary_format = 0;
+    CHECK(save_freezer_to_file("data/warehouse_1/frezzer3.txt", &f));
+    freezer_binary_format = 1;
+    frezzer_free(&f);
+    CHECK(generate_freezer_file("data/warehouse_1/frezzer7.txt", 50));  // 加一个，删一个
+    CHECK(remove("data/warehouse_1/frezzer5.txt") == 0);
+
+    CHECK(warehouse_snapshot_refresh("data/warehouse_1", &warm, &reloaded) && reloaded == 3);
+    CHECK(warm.freezer_count == 6);
+    CHECK(snapshot_matches_files("data/warehouse_1", &warm));
+    CHECK(remove("data/warehouse_1/warehouse.col") == 0);
+    CHECK(warehouse_snapshot_refresh("data/warehouse_1", &cold, &reloaded) && reloaded == 6);
+    CHECK(snapshot_same(&warm, &cold));
+    snapshot_free(&warm);
+    snapshot_free(&cold);
+    worker_threads = 0;
+    remove_dir_recursive("data");
+}
+
+int make_tree(const char* path) {  // 建一棵要删除的目录树：足够多的文件（分成几组并行删除）、几层子目录、空目录，以及指向树外目录的符号链接，成功返回1
+    char name[700];
+    int ok = mkdir(path, 0777) == 0;
+    for (int i = 0; ok && i < 3 * UNLINK_CHUNK + 5; i++) {
+        snprintf(name, sizeof(name), "%s/frezzer%d.txt", path, i);
+        FILE* fp = fopen(name, "w");
+        ok = fp != NULL && fputs("milk Dairy 1 -5\n", fp) >= 0;
+        if (fp != NULL) fclose(fp);
+    }
+    const char* dirs[] = {"sub", "sub/deep", "sub/deep/deeper", "empty"};
+    for (int i = 0; ok && i < 4; i++) {
+        snprintf(name, sizeof(name), "%s/%s", path, dirs[i]);
+        ok = mkdir(name, 0777) == 0;
+        snprintf(name, sizeof(name), "%s/%s/file", path, dirs[i]);
+        FILE* fp = i < 3 ? fopen(name, "w") : NULL;
+        if (fp != NULL) fclose(fp);
+    }
+    snprintf(name, sizeof(name), "%s/sub/link", path);
+    char target[600];
+    snprintf(target, sizeof(target), "%s/keep", check_dir);
+    return ok && symlink(target, name) == 0;
+}
+
+int tombstone_count() {  // data 下还剩几个墓碑目录
+    DIR* dir = opendir("data");
+    int n = 0;
+    if (dir == NULL) return 0;
+    for (struct dirent* e = readdir(dir); e != NULL; e = readdir(dir)) n += strncmp(e->d_name, ".deleted.", 9) == 0;
+    closedir(dir);
+    return n;
+}
+
+int wait_no_tombstones() {  // 等后台线程删完墓碑，最多等10秒，删完返回1
+    for (int i = 0; i < 1000 && tombstone_count() > 0; i++) usleep(10000);
+    return tombstone_count() == 0;
+}
+
+int path_exists(const char* path) {
+    struct stat st;
+    return lstat(path, &st) == 0;
+}
+
+void test_delete() {  // 删除目录树和仓库：嵌套的子目录和大量文件都删干净，不跟着符号链接删到树外，最后不留墓碑
+    worker_threads = 4;
+    CHECK(mkdir("keep", 0777) == 0);
+    FILE* fp = fopen("keep/file", "w");
+    if (fp != NULL) fclose(fp);
+
+    CHECK(make_tree("tree"));
+    CHECK(remove_dir_at(AT_FDCWD, "tree") == 1);
+    CHECK(!path_exists("tree"));
+    CHECK(remove_dir_at(AT_FDCWD, "tree") == 0);  // 已经不存在
+
+    CHECK(mkdir("data", 0777) == 0);
+    CHECK(make_tree("data/warehouse_1"));
+    delete_in_background = 1;  // 默认：改名为墓碑，后台删除
+    delete_warehouse("data/warehouse_1");
+    CHECK(!path_exists("data/warehouse_1"));  // 立刻从列表中消失
+    CHECK(wait_no_tombstones());
+
+    CHECK(make_tree("data/warehouse_2"));
+    delete_in_background = 0;  // FREZZER_DELETE=sync：当场删完
+    delete_warehouse("data/warehouse_2");
+    CHECK(!path_exists("data/warehouse_2") && tombstone_count() == 0);
+    delete_in_background = 1;
+
+    CHECK(make_tree("data/.deleted.warehouse_3.1"));  // 上次没删完的墓碑，启动时接着删
+    reclaim_tombstones();
+    CHECK(wait_no_tombstones());
+
+    CHECK(path_exists("keep/file"));  // 符号链接指向的目录没有被删
+    worker_threads = 0;
+    remove_dir_recursive("data");
+}
+
+int main() {
+    if (!check_begin()) return 1;
+    test_query();
+    test_snapshot();
+    test_delete();
+    return check_end("check_warehouse");
+}